@@ -0,0 +1,108 @@
+#include <string.h>
+#include "analog_pack.h"
+#include "protocol.h"
+
+void analog_pack_init(analog_pack_t *ap) {
+    memset(ap, 0, sizeof(*ap));
+    ap->key_mask = 0xFFFF;
+}
+
+// Next record of every channel is absolute (new host, lost frame...)
+void analog_pack_key(analog_pack_t *ap) {
+    ap->key_mask = 0xFFFF;
+}
+
+// Returns false when the buffer is full; send a frame first
+bool analog_pack_add(analog_pack_t *ap, uint8_t ch, int16_t value, uint32_t now_us) {
+    if (analog_pack_full(ap))
+        return false;
+    if (ap->count == 0)
+        ap->first_us = now_us;
+    ap->pending[ap->count].ch = ch & (ANALOG_CHANNELS - 1);
+    ap->pending[ap->count].value = value;
+    ap->count++;
+    return true;
+}
+
+// A frame is due once the buffer is full or the oldest update has waited
+// hold_us; hold_us 0 sends every update right away
+bool analog_pack_due(const analog_pack_t *ap, uint32_t now_us, uint32_t hold_us) {
+    if (ap->count == 0)
+        return false;
+    return analog_pack_full(ap) || now_us - ap->first_us >= hold_us;
+}
+
+static size_t put_key(analog_pack_t *ap, uint8_t *out, const analog_sample_t *s) {
+    out[0] = PROTO_REC_KEY | s->ch;
+    out[1] = (s->value >> 8) & 0xFF;
+    out[2] = s->value & 0xFF;
+    ap->last[s->ch] = s->value;
+    ap->since_key[s->ch] = 0;
+    ap->key_mask &= ~(1u << s->ch);
+    return 3;
+}
+
+// Consecutive updates of one channel starting at pending[start]: a single
+// DELTA record, or RUN | channel, count and one zig-zag varint each.
+// Stops before the update that is due for a keyframe.
+static size_t put_run(analog_pack_t *ap, uint8_t *out, size_t room, int start, int *used) {
+    uint8_t ch = ap->pending[start].ch;
+    int limit = ANALOG_KEY_EVERY - ap->since_key[ch];
+    uint8_t deltas[ANALOG_RUN_MAX * 3];
+    size_t dlen = 0, fit_len = 0;
+    int n = 0, fit_n = 0;
+    int16_t base = ap->last[ch];
+
+    for (int i = start; i < ap->count && ap->pending[i].ch == ch && n < limit; i++) {
+        dlen += proto_put_varint(&deltas[dlen], proto_zigzag((int16_t)(ap->pending[i].value - base)));
+        base = ap->pending[i].value;
+        n++;
+        if ((n == 1 ? 1 : 2) + dlen > room)
+            break;
+        fit_len = dlen;
+        fit_n = n;
+    }
+    if (fit_n == 0)
+        return 0;
+
+    size_t len;
+    if (fit_n == 1) {
+        out[0] = PROTO_REC_DELTA | ch;
+        len = 1;
+    } else {
+        out[0] = PROTO_REC_RUN | ch;
+        out[1] = fit_n;
+        len = 2;
+    }
+    memcpy(&out[len], deltas, fit_len);
+    ap->last[ch] = ap->pending[start + fit_n - 1].value;
+    ap->since_key[ch] += fit_n;
+    *used = fit_n;
+    return len + fit_len;
+}
+
+// Writes as many pending updates as fit in room and removes them from the
+// buffer. Returns the record bytes, 0 if nothing fits.
+size_t analog_pack_records(analog_pack_t *ap, uint8_t *out, size_t room) {
+    size_t len = 0;
+    int i = 0;
+
+    while (i < ap->count) {
+        const analog_sample_t *s = &ap->pending[i];
+        int used = 1;
+        size_t n;
+
+        if ((ap->key_mask & (1u << s->ch)) || ap->since_key[s->ch] >= ANALOG_KEY_EVERY)
+            n = len + 3 <= room ? put_key(ap, &out[len], s) : 0;
+        else
+            n = put_run(ap, &out[len], room - len, i, &used);
+        if (n == 0)
+            break;
+        len += n;
+        i += used;
+    }
+
+    ap->count -= i;
+    memmove(ap->pending, &ap->pending[i], ap->count * sizeof(ap->pending[0]));
+    return len;
+}
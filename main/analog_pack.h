@@ -0,0 +1,42 @@
+#ifndef ANALOG_PACK_H
+#define ANALOG_PACK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Compact analog records (PROTO_FMT_COMPACT_ANALOG). Updates are held for
+// a while and go out as runs, several per frame, so the per-frame cost
+// (seq, CRC, COBS code, delimiter) is shared by every update in it.
+
+#define ANALOG_CHANNELS  16
+#define ANALOG_RUN_MAX   8   // updates held before a frame goes out anyway
+// An absolute value every few updates bounds how long a lost delta can
+// skew the host
+#define ANALOG_KEY_EVERY 32
+
+typedef struct {
+    uint8_t ch;
+    int16_t value;
+} analog_sample_t;
+
+typedef struct {
+    int16_t last[ANALOG_CHANNELS];  // last value the host was sent
+    uint8_t since_key[ANALOG_CHANNELS];
+    uint16_t key_mask;              // channels whose next record must be a keyframe
+    analog_sample_t pending[ANALOG_RUN_MAX];
+    uint8_t count;
+    uint32_t first_us;              // when the oldest pending update arrived
+} analog_pack_t;
+
+void analog_pack_init(analog_pack_t *ap);
+void analog_pack_key(analog_pack_t *ap);
+bool analog_pack_add(analog_pack_t *ap, uint8_t ch, int16_t value, uint32_t now_us);
+bool analog_pack_due(const analog_pack_t *ap, uint32_t now_us, uint32_t hold_us);
+size_t analog_pack_records(analog_pack_t *ap, uint8_t *out, size_t room);
+
+static inline bool analog_pack_full(const analog_pack_t *ap) {
+    return ap->count >= ANALOG_RUN_MAX;
+}
+
+#endif
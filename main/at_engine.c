@@ -0,0 +1,143 @@
+#include "at_engine.h"
+#include "task.h"
+#include <string.h>
+
+#define AT_RX_RING_SIZE 64  // power of two
+#define AT_POLL_MS      10
+
+typedef enum {
+    AT_IDLE = 0,
+    AT_HOLD,   // waiting for the line to go idle before sending
+    AT_WAIT,   // command sent, assembling the reply
+} at_phase_t;
+
+static const at_port_t *at_port;
+
+static at_command_t queue[AT_QUEUE_LEN];
+static uint8_t q_head = 0;
+static uint8_t q_tail = 0;
+
+static at_command_t current;
+static at_phase_t phase = AT_IDLE;
+static TickType_t deadline;
+
+// Filled by the RX interrupt only while a command is waiting for its reply
+static volatile bool capturing = false;
+static uint8_t rx_ring[AT_RX_RING_SIZE];
+static volatile uint8_t rx_head = 0;
+static volatile uint8_t rx_tail = 0;
+
+static char line[AT_LINE_MAX];
+static size_t line_len = 0;
+
+void at_engine_init(const at_port_t *port) {
+    at_port = port;
+    q_head = q_tail = 0;
+    phase = AT_IDLE;
+}
+
+bool at_engine_submit(const at_command_t *cmd) {
+    if ((uint8_t)(q_head - q_tail) >= AT_QUEUE_LEN)
+        return false;
+
+    queue[q_head % AT_QUEUE_LEN] = *cmd;
+    queue[q_head % AT_QUEUE_LEN].cmd[AT_CMD_MAX - 1] = '\0';
+    q_head++;
+    return true;
+}
+
+bool at_engine_busy(void) {
+    return phase != AT_IDLE;
+}
+
+// Returns false when the byte is not for us, so the caller can route it
+// elsewhere. Bytes that do not fit are dropped; a reply that long cannot
+// match anyway.
+bool at_engine_rx_from_isr(uint8_t c) {
+    if (!capturing)
+        return false;
+
+    if ((uint8_t)(rx_head - rx_tail) < AT_RX_RING_SIZE) {
+        rx_ring[rx_head % AT_RX_RING_SIZE] = c;
+        rx_head++;
+    }
+    return true;
+}
+
+static bool line_matches(const char *pattern) {
+    return pattern != NULL && pattern[0] != '\0' && strstr(line, pattern) != NULL;
+}
+
+// Moves received bytes into the line buffer. Returns 1 on success,
+// -1 on an explicit failure, 0 if the reply is not complete yet. Modules
+// like the HC-06 never send CR/LF, so the partial line is matched too.
+static int assemble(void) {
+    while (rx_tail != rx_head) {
+        char c = rx_ring[rx_tail % AT_RX_RING_SIZE];
+        rx_tail++;
+
+        if (c == '\r' || c == '\n') {
+            if (line_matches(current.expect))
+                return 1;
+            if (line_matches(current.fail))
+                return -1;
+            line_len = 0;
+            line[0] = '\0';
+            continue;
+        }
+        if (line_len < AT_LINE_MAX - 1) {
+            line[line_len++] = c;
+            line[line_len] = '\0';
+        }
+    }
+
+    if (line_matches(current.expect))
+        return 1;
+    if (line_matches(current.fail))
+        return -1;
+    return 0;
+}
+
+static void finish(bool ok) {
+    capturing = false;
+    phase = AT_IDLE;
+    if (current.done != NULL)
+        current.done(ok, line, current.ctx);
+}
+
+// Returns how long the caller can sleep before polling again
+TickType_t at_engine_poll(void) {
+    switch (phase) {
+    case AT_IDLE:
+        if (q_tail == q_head)
+            return portMAX_DELAY;
+        current = queue[q_tail % AT_QUEUE_LEN];
+        q_tail++;
+        phase = AT_HOLD;
+        // fall through
+
+    case AT_HOLD:
+        if (!at_port->tx_idle())
+            return 1;
+        if (current.on_send != NULL)
+            current.on_send(current.ctx);
+
+        line_len = 0;
+        line[0] = '\0';
+        rx_tail = rx_head;
+        capturing = true;
+        at_port->write((const uint8_t *)current.cmd, strlen(current.cmd));
+        deadline = xTaskGetTickCount() + pdMS_TO_TICKS(current.timeout_ms);
+        phase = AT_WAIT;
+        return pdMS_TO_TICKS(AT_POLL_MS);
+
+    case AT_WAIT: {
+        int result = assemble();
+        if (result == 0 && (int32_t)(xTaskGetTickCount() - deadline) < 0)
+            return pdMS_TO_TICKS(AT_POLL_MS);
+        finish(result > 0);
+        return 1;
+    }
+    }
+    return portMAX_DELAY;
+}
@@ -0,0 +1,40 @@
+#ifndef AT_ENGINE_H
+#define AT_ENGINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "FreeRTOS.h"
+
+// Non-blocking engine for AT-style modules. Commands are queued and sent
+// one at a time from at_engine_poll(); the reply is fed byte by byte from
+// the UART RX interrupt and assembled into lines in task context.
+
+#define AT_CMD_MAX    32
+#define AT_LINE_MAX   32
+#define AT_QUEUE_LEN  4
+
+typedef void (*at_callback_t)(bool ok, const char *response, void *ctx);
+
+typedef struct {
+    char cmd[AT_CMD_MAX];
+    const char *expect;        // substring of a reply line that means success
+    const char *fail;          // optional substring that means failure right away
+    uint16_t timeout_ms;
+    void (*on_send)(void *ctx); // optional, runs once the line is idle, right before sending
+    at_callback_t done;
+    void *ctx;
+} at_command_t;
+
+typedef struct {
+    bool (*write)(const uint8_t *data, size_t len);
+    bool (*tx_idle)(void);
+} at_port_t;
+
+void at_engine_init(const at_port_t *port);
+bool at_engine_submit(const at_command_t *cmd);
+bool at_engine_busy(void);
+TickType_t at_engine_poll(void);
+bool at_engine_rx_from_isr(uint8_t c);
+
+#endif
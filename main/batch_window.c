@@ -0,0 +1,23 @@
+#include <string.h>
+#include "batch_window.h"
+
+void batch_window_init(batch_window_t *bw) {
+    memset(bw, 0, sizeof(*bw));
+}
+
+void batch_window_probe(batch_window_t *bw, uint32_t rtt_us, uint16_t packet_us, uint32_t limit_us) {
+    uint32_t target = packet_us / 2;
+
+    bw->rtt_us = bw->rtt_us ? (7 * bw->rtt_us + rtt_us) / 8 : rtt_us;
+    if (bw->rtt_min_us == 0 || rtt_us < bw->rtt_min_us)
+        bw->rtt_min_us = rtt_us;
+    else
+        bw->rtt_min_us += (rtt_us - bw->rtt_min_us) / 32;
+
+    if (packet_us > 0 && bw->rtt_us > bw->rtt_min_us + packet_us)
+        bw->window_us = bw->window_us >= target ? 2 * bw->window_us : target;
+    else
+        bw->window_us /= 2;
+    if (bw->window_us > limit_us)
+        bw->window_us = limit_us;
+}
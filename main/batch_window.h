@@ -0,0 +1,26 @@
+#ifndef BATCH_WINDOW_H
+#define BATCH_WINDOW_H
+
+#include <stdint.h>
+
+// Adaptive batching window, driven by the RTT of the latency probes. The
+// HC-06 groups bytes into radio packets on its own schedule, so on a
+// quiet link frames written a few ms apart already share a packet and
+// holding them back only adds latency: the window stays 0. When the
+// smoothed RTT climbs a packet interval above its floor, packets are
+// queuing in the module; the window then opens at half a packet interval
+// and doubles on every probe while the queue lasts, so fewer, fuller
+// writes go out. It halves back once the RTT settles.
+
+typedef struct {
+    uint32_t window_us;
+    uint32_t rtt_us;      // smoothed
+    uint32_t rtt_min_us;  // floor, drifts up slowly so it can follow the link
+} batch_window_t;
+
+void batch_window_init(batch_window_t *bw);
+// packet_us is the host's estimate of the radio packet interval, 0 when
+// it has none; the window never exceeds limit_us
+void batch_window_probe(batch_window_t *bw, uint32_t rtt_us, uint16_t packet_us, uint32_t limit_us);
+
+#endif
@@ -1,32 +1,33 @@
 #include "button.h"
 #include "common.h"
+#include "event_bus.h"
+#include "settings.h"
 #include "hardware/gpio.h"
 #include "FreeRTOS.h"
 #include "task.h"
-#include "queue.h"
-
-extern QueueHandle_t xQueueBTN;
 
 void button_task(void *p) {
-    button_config_t btn = *(button_config_t *)p;
-    gpio_init(btn.gpio);
-    gpio_set_dir(btn.gpio, GPIO_IN);
-    gpio_pull_up(btn.gpio);
+    // Not a copy: the host can remap btn->code at runtime
+    button_config_t *btn = (button_config_t *)p;
+    gpio_init(btn->gpio);
+    gpio_set_dir(btn->gpio, GPIO_IN);
+    gpio_pull_up(btn->gpio);
 
     bool last_state = true;
+    uint8_t pressed_code = 0;
 
     while (1) {
-        bool current_state = gpio_get(btn.gpio);
+        bool current_state = gpio_get(btn->gpio);
 
         if (last_state && !current_state) {
-            uint8_t code = btn.code;
-            xQueueSend(xQueueBTN, &code, portMAX_DELAY);
+            pressed_code = btn->code;
+            bus_post_event(EV_SRC_BUTTON, pressed_code, 1);
         } else if (!last_state && current_state) {
-            uint8_t code = btn.code | 0x80;
-            xQueueSend(xQueueBTN, &code, portMAX_DELAY);
+            // Release what was pressed, even if remapped in between
+            bus_post_event(EV_SRC_BUTTON, pressed_code, 0);
         }
 
         last_state = current_state;
-        vTaskDelay(pdMS_TO_TICKS(20));
+        vTaskDelay(pdMS_TO_TICKS(settings.button_period_ms));
     }
 }
@@ -0,0 +1,284 @@
+#include "command.h"
+#include "common.h"
+#include "protocol.h"
+#include "settings.h"
+#include "event_bus.h"
+#include "uart_rx.h"
+#include "uart_tx.h"
+#include "hc06_task.h"
+#include "hc06.h"
+#include "transport.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+static uint32_t bad_frames = 0;
+
+static void put_u16(uint8_t *out, uint32_t v) {
+    if (v > 0xFFFF)
+        v = 0xFFFF;
+    out[0] = (v >> 8) & 0xFF;
+    out[1] = v & 0xFF;
+}
+
+// Replies are packed with the generated layouts, leaving out the seq byte:
+// hc06_task adds its own when the frame goes out
+static void reply_status(uint8_t cmd, uint8_t status) {
+    uint8_t reply[PROTO_FRAME_CMD_OK_LEN];
+    size_t len = proto_pack_cmd_ok(reply, 0, cmd, status);
+    hc06_task_send_control(&reply[1], len - 1);
+}
+
+// [code, one 16-bit saturating field per PROTO_STAT_*]
+static void reply_stats(void) {
+    uint8_t reply[1 + PROTO_STAT_COUNT * 2];
+    bus_stats_t btn, fsr, pot;
+    uart_tx_stats_t tx;
+    uint32_t report_period, report_jitter;
+    uint32_t batch_window, probe_rtt;
+
+    bus_get_stats(EV_SRC_BUTTON, &btn);
+    bus_get_stats(EV_SRC_FSR, &fsr);
+    bus_get_stats(EV_SRC_POT, &pot);
+    uart_tx_get_stats(&tx);
+    hc06_task_report_stats(&report_period, &report_jitter);
+    hc06_task_batch_stats(&batch_window, &probe_rtt);
+
+    reply[0] = PROTO_CODE_STATS;
+    put_u16(&reply[1 + 2 * PROTO_STAT_BTN_DROPS], btn.drops);
+    put_u16(&reply[1 + 2 * PROTO_STAT_FSR_DROPS], fsr.drops);
+    put_u16(&reply[1 + 2 * PROTO_STAT_POT_COALESCED], pot.coalesced);
+    put_u16(&reply[1 + 2 * PROTO_STAT_TX_OVERFLOWS], tx.overflows);
+    put_u16(&reply[1 + 2 * PROTO_STAT_TX_PEAK], tx.peak_fill);
+    put_u16(&reply[1 + 2 * PROTO_STAT_RX_OVERFLOWS], uart_rx_overflows());
+    put_u16(&reply[1 + 2 * PROTO_STAT_BAD_CMD_FRAMES], bad_frames);
+    put_u16(&reply[1 + 2 * PROTO_STAT_BAUD_X100], hc06_get_baud() / 100);
+    put_u16(&reply[1 + 2 * PROTO_STAT_RETRANSMITS], hc06_task_retransmits());
+    put_u16(&reply[1 + 2 * PROTO_STAT_EDGE_QUEUE_US], hc06_task_edge_latency_max());
+    put_u16(&reply[1 + 2 * PROTO_STAT_EDGE_LINE_US], tx.edge_wait_max_us);
+    put_u16(&reply[1 + 2 * PROTO_STAT_REPORT_PERIOD_10US], report_period / 10);
+    put_u16(&reply[1 + 2 * PROTO_STAT_REPORT_JITTER_10US], report_jitter / 10);
+    put_u16(&reply[1 + 2 * PROTO_STAT_BATCH_WINDOW_US], batch_window);
+    put_u16(&reply[1 + 2 * PROTO_STAT_PROBE_RTT_X100US], probe_rtt / 100);
+    hc06_task_send_control(reply, sizeof(reply));
+}
+
+// Announces what this firmware speaks, so the host can pick the best
+// format both sides support. Sent whenever a link comes up and on
+// PROTO_CMD_HELLO; the button code table follows the fixed fields.
+void command_announce(void) {
+    uint8_t reply[PROTO_FRAME_HELLO_LEN + NUM_BUTTONS];
+    uint16_t heartbeat = settings.heartbeat_ms / 10;
+
+    size_t len = proto_pack_hello(reply, 0, PROTO_VERSION, PROTO_FMT_SUPPORTED, 1 << AXIS_POT,
+                                  portTICK_PERIOD_MS, heartbeat > 0xFF ? 0xFF : heartbeat,
+                                  AXIS_FSR, 3, NUM_BUTTONS);
+    for (int i = 0; i < NUM_BUTTONS; i++)
+        reply[len++] = buttons[i].code;
+    hc06_task_send_control(&reply[1], len - 1);
+}
+
+// [code, count, one PROTO_FRAME_LINK_LEN record per transport]
+static void reply_links(void) {
+    uint8_t reply[2 + TRANSPORT_MAX * PROTO_FRAME_LINK_LEN];
+    size_t len = 2;
+
+    reply[0] = PROTO_CODE_LINKS;
+    reply[1] = transport_count();
+    for (size_t i = 0; i < transport_count(); i++) {
+        transport_t *t = transport_get(i);
+        size_t pending = t->pending(TRANSPORT_LANE_EDGE) + t->pending(TRANSPORT_LANE_BULK);
+        len += proto_pack_link(&reply[len], t->id, t->ready(),
+                               pending > 0xFFFF ? 0xFFFF : pending,
+                               t->stats.drops > 0xFFFF ? 0xFFFF : t->stats.drops,
+                               t->stats.latency_max_us > 0xFFFF ? 0xFFFF : t->stats.latency_max_us);
+    }
+    hc06_task_send_control(reply, len);
+}
+
+static bool set_scan(uint8_t target, uint16_t ms) {
+    // Anything shorter than a tick would turn the scan into a busy loop
+    if (ms < portTICK_PERIOD_MS)
+        return false;
+
+    switch (target) {
+    case PROTO_SCAN_BUTTON: settings.button_period_ms = ms; return true;
+    case PROTO_SCAN_POT:    settings.pot_period_ms = ms; return true;
+    case PROTO_SCAN_FSR:    settings.fsr_period_ms = ms; return true;
+    case PROTO_SCAN_HEARTBEAT: settings.heartbeat_ms = ms; return true;
+    }
+    return false;
+}
+
+static bool set_threshold(uint8_t id, uint16_t value) {
+    switch (id) {
+    case PROTO_THRESH_FSR_PRESS:
+        if (value >= 4095) return false;
+        settings.fsr_press_raw = value;
+        return true;
+    case PROTO_THRESH_FSR_LVL2:
+        if (value > 255) return false;
+        settings.fsr_lvl2 = value;
+        return true;
+    case PROTO_THRESH_FSR_LVL3:
+        if (value > 255) return false;
+        settings.fsr_lvl3 = value;
+        return true;
+    case PROTO_THRESH_POT_DEADBAND:
+        if (value > 255) return false;
+        settings.pot_deadband = value;
+        return true;
+    case PROTO_THRESH_BATCH_LIMIT_MS:
+        if (value > 50) return false;
+        settings.batch_limit_ms = value;
+        return true;
+    case PROTO_THRESH_ANALOG_HOLD_MS:
+        if (value > 1000) return false;
+        settings.analog_hold_ms = value;
+        return true;
+    }
+    return false;
+}
+
+static void handle_command(transport_t *src, const uint8_t *cmd, size_t len) {
+    bool ok = false;
+
+    switch (cmd[0]) {
+    case PROTO_CMD_KEEPALIVE:
+        if (src->keepalive != NULL)
+            src->keepalive();
+        return;
+
+    case PROTO_CMD_PING:
+        if (len == PROTO_CMD_PING_LEN) {
+            uint8_t reply[PROTO_FRAME_PONG_LEN];
+            proto_pack_pong(reply, 0, (cmd[1] << 8) | cmd[2]);
+            hc06_task_send_control(&reply[1], sizeof(reply) - 1);
+        }
+        return;
+
+    case PROTO_CMD_GET_STATS:
+        reply_stats();
+        return;
+
+    case PROTO_CMD_RESYNC:
+        hc06_task_request_resync();
+        return;
+
+    case PROTO_CMD_HELLO:
+        command_announce();
+        return;
+
+    case PROTO_CMD_TIME:
+        if (len == PROTO_CMD_TIME_LEN) {
+            // tx_us is filled in by hc06_task when the reply goes out
+            uint8_t reply[PROTO_FRAME_TIME_LEN];
+            proto_pack_time(reply, 0, (cmd[1] << 8) | cmd[2], time_us_32(), 0);
+            hc06_task_send_control(&reply[1], sizeof(reply) - 1);
+        }
+        return;
+
+    case PROTO_CMD_GET_LINKS:
+        reply_links();
+        return;
+
+    case PROTO_CMD_ECHO:
+        if (len == PROTO_CMD_ECHO_LEN)
+            hc06_task_echo(((uint32_t)cmd[1] << 24) | ((uint32_t)cmd[2] << 16) | (cmd[3] << 8) | cmd[4],
+                           (cmd[5] << 8) | cmd[6]);
+        return;
+
+    case PROTO_CMD_ACK:
+        if (len == PROTO_CMD_ACK_LEN)
+            hc06_task_ack(cmd[1], cmd[2]);
+        return;
+
+    case PROTO_CMD_SET_SCAN:
+        ok = len == PROTO_CMD_SET_SCAN_LEN && set_scan(cmd[1], (cmd[2] << 8) | cmd[3]);
+        break;
+
+    case PROTO_CMD_SET_THRESH:
+        ok = len == PROTO_CMD_SET_THRESH_LEN && set_threshold(cmd[1], (cmd[2] << 8) | cmd[3]);
+        break;
+
+    case PROTO_CMD_SET_FORMAT:
+        ok = len == PROTO_CMD_SET_FORMAT_LEN && (cmd[1] & ~PROTO_FMT_SUPPORTED) == 0;
+        if (ok) {
+            settings.wire_format = cmd[1];
+            // The host needs a keyframe before it can apply deltas
+            hc06_task_request_resync();
+        }
+        break;
+
+    case PROTO_CMD_SET_REPORT:
+        // 0 goes back to events; below 2 ms the state frames alone would
+        // fill most of the HC-06 line
+        ok = len == PROTO_CMD_SET_REPORT_LEN && (cmd[1] == 0 || (cmd[1] >= 2 && cmd[1] <= 100));
+        if (ok)
+            settings.report_ms = cmd[1];
+        break;
+
+    case PROTO_CMD_REMAP:
+        // Codes must stay in the input range so they never collide with
+        // control replies or the release bit
+        ok = len == PROTO_CMD_REMAP_LEN && cmd[1] < NUM_BUTTONS && cmd[2] >= 0x01 && cmd[2] <= 0x0F;
+        if (ok)
+            buttons[cmd[1]].code = cmd[2];
+        break;
+    }
+    reply_status(cmd[0], ok ? PROTO_STATUS_OK : PROTO_STATUS_ERR);
+}
+
+// Each link has its own partial frame, so bytes from one never end up
+// in a frame from another
+typedef struct {
+    uint8_t frame[PROTO_MAX_FRAME];
+    size_t len;
+    bool overrun;
+} rx_frame_t;
+
+static rx_frame_t rx_frames[TRANSPORT_MAX];
+
+static void feed(transport_t *src, rx_frame_t *rx, const uint8_t *data, size_t n) {
+    uint8_t payload[PROTO_MAX_PAYLOAD];
+
+    for (size_t i = 0; i < n; i++) {
+        if (data[i] != PROTO_DELIMITER) {
+            if (rx->len < sizeof(rx->frame))
+                rx->frame[rx->len++] = data[i];
+            else
+                rx->overrun = true;
+            continue;
+        }
+
+        if (rx->len > 0) {
+            size_t plen = rx->overrun ? 0 : proto_decode_frame(rx->frame, rx->len, payload);
+            if (plen > 0)
+                handle_command(src, payload, plen);
+            else
+                bad_frames++;
+        }
+        rx->len = 0;
+        rx->overrun = false;
+    }
+}
+
+void command_task(void *p) {
+    uint8_t chunk[16];
+
+    // Frames stay in the original format until a host asks for more. No
+    // HELLO here: no link is up yet, hc06_task sends it once one is.
+    transport_set_rx_notify(xTaskGetCurrentTaskHandle());
+
+    // Reads first: bytes that arrived before the notify was set up did
+    // not wake anyone. After that every byte does, so no timeout.
+    while (1) {
+        for (size_t i = 0; i < transport_count(); i++) {
+            transport_t *t = transport_get(i);
+            size_t n;
+            while ((n = t->read(chunk, sizeof(chunk))) > 0)
+                feed(t, &rx_frames[i], chunk, n);
+        }
+
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
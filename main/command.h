@@ -0,0 +1,11 @@
+#ifndef COMMAND_H
+#define COMMAND_H
+
+// Reads host commands from the HC-06 RX stream and applies them
+void command_task(void *p);
+
+// Queues a HELLO; hc06_task announces itself this way whenever a link
+// comes up
+void command_announce(void);
+
+#endif
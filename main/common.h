@@ -13,19 +13,11 @@
 
 #define AXIS_FSR 6
 
-#define HC06_UART_ID uart1
-#define HC06_BAUD_RATE 9600
-#define HC06_TX_PIN 4
-#define HC06_RX_PIN 5
-
-typedef struct {
-    uint8_t axis;
-    int16_t value;
-} adc_data_t;
-
 typedef struct {
     uint gpio;
     uint8_t code;
 } button_config_t;
 
+extern button_config_t buttons[NUM_BUTTONS];
+
 #endif
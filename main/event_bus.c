@@ -0,0 +1,188 @@
+#include "event_bus.h"
+#include "pico/stdlib.h"
+
+static bus_subscriber_t *subscribers[BUS_MAX_SUBSCRIBERS];
+static int num_subscribers = 0;
+
+// Producers must never stall behind the transport: edges are never
+// coalesced, and when they have to be dropped the subscriber is flagged so
+// it can resync. Analog readings only need the latest value.
+static bus_policy_t policies[EV_SRC_COUNT] = {
+    [EV_SRC_BUTTON] = BUS_DROP_OLDEST,
+    [EV_SRC_FSR]    = BUS_DROP_OLDEST,
+    [EV_SRC_POT]    = BUS_COALESCE,
+};
+static bus_stats_t stats[EV_SRC_COUNT];
+static input_state_t input_state;
+
+// Subscriptions are made from main() before the scheduler starts, so the
+// list is read-only once tasks are running.
+void bus_subscribe(bus_subscriber_t *sub, uint32_t mask, event_t *storage, UBaseType_t depth) {
+    if (num_subscribers >= BUS_MAX_SUBSCRIBERS)
+        return;
+
+    sub->queue = xQueueCreateStatic(depth, sizeof(event_t), (uint8_t *)storage, &sub->queue_buffer);
+    sub->mask = mask;
+    sub->notify = NULL;
+    sub->overflowed = false;
+    for (int i = 0; i < BUS_COALESCE_SLOTS; i++)
+        sub->slot_pending[i] = false;
+    subscribers[num_subscribers++] = sub;
+}
+
+void bus_set_policy(uint8_t source, bus_policy_t policy) {
+    if (source < EV_SRC_COUNT)
+        policies[source] = policy;
+}
+
+static void count_drop(bus_subscriber_t *sub, uint8_t source) {
+    stats[source].drops++;
+    sub->overflowed = true;
+}
+
+// Returns false if the event did not need a new queue entry
+static bool coalesce(bus_subscriber_t *sub, const event_t *ev, bool *dropped) {
+    int free_slot = -1;
+    bool merged = false;
+
+    taskENTER_CRITICAL();
+    for (int i = 0; i < BUS_COALESCE_SLOTS; i++) {
+        if (!sub->slot_pending[i]) {
+            if (free_slot < 0)
+                free_slot = i;
+        } else if (sub->slots[i].source == ev->source && sub->slots[i].code == ev->code) {
+            sub->slots[i] = *ev;
+            merged = true;
+            break;
+        }
+    }
+    if (!merged && free_slot >= 0) {
+        sub->slots[free_slot] = *ev;
+        sub->slot_pending[free_slot] = true;
+    }
+    taskEXIT_CRITICAL();
+
+    *dropped = !merged && free_slot < 0;
+    if (merged)
+        stats[ev->source].coalesced++;
+    return !merged && free_slot >= 0;
+}
+
+// Replaces ev with the pending slot for its (source, code), if any
+static void take_slot(bus_subscriber_t *sub, event_t *ev) {
+    taskENTER_CRITICAL();
+    for (int i = 0; i < BUS_COALESCE_SLOTS; i++) {
+        if (sub->slot_pending[i] && sub->slots[i].source == ev->source &&
+            sub->slots[i].code == ev->code) {
+            *ev = sub->slots[i];
+            sub->slot_pending[i] = false;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+static bool deliver(bus_subscriber_t *sub, const event_t *ev) {
+    event_t marker = *ev;
+    bool dropped = false;
+
+    switch (policies[ev->source]) {
+    case BUS_BLOCK:
+        return xQueueSend(sub->queue, ev, portMAX_DELAY) == pdTRUE;
+
+    case BUS_DROP_NEWEST:
+        if (xQueueSend(sub->queue, ev, 0) != pdTRUE) {
+            count_drop(sub, ev->source);
+            return false;
+        }
+        return true;
+
+    case BUS_DROP_OLDEST:
+        vTaskSuspendAll();
+        if (xQueueSend(sub->queue, ev, 0) != pdTRUE) {
+            event_t oldest;
+            xQueueReceive(sub->queue, &oldest, 0);
+            xQueueSend(sub->queue, ev, 0);
+            count_drop(sub, oldest.source);
+        }
+        xTaskResumeAll();
+        return true;
+
+    case BUS_COALESCE:
+        if (!coalesce(sub, ev, &dropped)) {
+            if (dropped)
+                count_drop(sub, ev->source);
+            return false;
+        }
+        // The queue entry is only a marker, bus_receive picks up the value
+        if (xQueueSend(sub->queue, ev, 0) != pdTRUE) {
+            take_slot(sub, &marker);
+            count_drop(sub, ev->source);
+            return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+// Each subscriber queue gets its own copy of the 8-byte event rather than
+// an index into a shared ring: the queue operation costs the same either
+// way (tests/bench_event_bus.c), and per-subscriber copies let every queue
+// drop or coalesce on its own.
+void bus_post(const event_t *ev) {
+    if (ev->source >= EV_SRC_COUNT)
+        return;
+
+    stats[ev->source].posted++;
+
+    taskENTER_CRITICAL();
+    if (ev->source == EV_SRC_POT) {
+        input_state.pot = ev->value;
+    } else if (ev->code < 16) {
+        if (ev->value)
+            input_state.pressed |= 1u << ev->code;
+        else
+            input_state.pressed &= ~(1u << ev->code);
+    }
+    taskEXIT_CRITICAL();
+
+    for (int i = 0; i < num_subscribers; i++) {
+        bus_subscriber_t *sub = subscribers[i];
+        if (!(sub->mask & EV_MASK(ev->source)))
+            continue;
+
+        if (deliver(sub, ev) && sub->notify != NULL)
+            xTaskNotifyGive(sub->notify);
+    }
+}
+
+void bus_post_event(uint8_t source, uint8_t code, int16_t value) {
+    event_t ev = {
+        .source = source,
+        .code = code,
+        .value = value,
+        .timestamp = time_us_32(),
+    };
+    bus_post(&ev);
+}
+
+// Like xQueueReceive, but a coalesced entry is replaced by the latest
+// value posted for its (source, code).
+bool bus_receive(bus_subscriber_t *sub, event_t *ev, TickType_t wait) {
+    if (xQueueReceive(sub->queue, ev, wait) != pdTRUE)
+        return false;
+
+    take_slot(sub, ev);
+    return true;
+}
+
+void bus_get_stats(uint8_t source, bus_stats_t *out) {
+    if (source < EV_SRC_COUNT)
+        *out = stats[source];
+}
+
+void bus_get_state(input_state_t *out) {
+    taskENTER_CRITICAL();
+    *out = input_state;
+    taskEXIT_CRITICAL();
+}
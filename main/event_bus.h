@@ -0,0 +1,71 @@
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "task.h"
+
+typedef enum {
+    EV_SRC_BUTTON = 0,
+    EV_SRC_FSR,
+    EV_SRC_POT,
+    EV_SRC_COUNT
+} event_source_t;
+
+#define EV_MASK(src) (1u << (src))
+
+// Edge sources use value 1 for press and 0 for release; analog sources
+// carry the converted reading.
+typedef struct {
+    uint8_t source;
+    uint8_t code;
+    int16_t value;
+    uint32_t timestamp;  // time_us_32() when the producer saw it
+} event_t;
+
+// What bus_post does when a subscriber queue is full
+typedef enum {
+    BUS_BLOCK = 0,     // wait for room (stalls the producer)
+    BUS_DROP_OLDEST,   // discard the oldest queued event
+    BUS_DROP_NEWEST,   // discard the event being posted
+    BUS_COALESCE,      // keep only the latest value per (source, code)
+} bus_policy_t;
+
+typedef struct {
+    uint32_t posted;
+    uint32_t drops;
+    uint32_t coalesced;
+} bus_stats_t;
+
+// Current input state as posted by the producers, regardless of what the
+// subscribers managed to queue
+typedef struct {
+    uint16_t pressed;  // bit n set while edge code n is held (buttons and FSR level)
+    int16_t pot;
+} input_state_t;
+
+#define BUS_MAX_SUBSCRIBERS 4
+#define BUS_COALESCE_SLOTS  4
+
+// Subscribers own their queue storage, so the bus never allocates.
+typedef struct {
+    QueueHandle_t queue;
+    StaticQueue_t queue_buffer;
+    uint32_t mask;
+    TaskHandle_t notify;      // optional, woken after every delivery
+    volatile bool overflowed; // set whenever an event for this subscriber was dropped
+    event_t slots[BUS_COALESCE_SLOTS];
+    bool slot_pending[BUS_COALESCE_SLOTS];
+} bus_subscriber_t;
+
+void bus_subscribe(bus_subscriber_t *sub, uint32_t mask, event_t *storage, UBaseType_t depth);
+void bus_set_policy(uint8_t source, bus_policy_t policy);
+void bus_post(const event_t *ev);
+void bus_post_event(uint8_t source, uint8_t code, int16_t value);
+bool bus_receive(bus_subscriber_t *sub, event_t *ev, TickType_t wait);
+void bus_get_stats(uint8_t source, bus_stats_t *stats);
+void bus_get_state(input_state_t *state);
+
+#endif
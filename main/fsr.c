@@ -1,16 +1,16 @@
 #include "fsr.h"
 #include "common.h"
+#include "event_bus.h"
+#include "settings.h"
 #include "hardware/adc.h"
 #include "FreeRTOS.h"
 #include "task.h"
-#include "queue.h"
-
-extern QueueHandle_t xQueueBTN;
 
 static int16_t process_adc_value(uint16_t raw, uint8_t axis) {
     if (axis == AXIS_FSR) {
-        if (raw < 300) return 0;
-        return (raw - 300) * 255 / (4095 - 300);
+        uint16_t threshold = settings.fsr_press_raw;
+        if (raw < threshold) return 0;
+        return (raw - threshold) * 255 / (4095 - threshold);
     }
     int16_t val = ((int32_t)raw - 2048) * 255 / 2048;
     if (val < 30 && val > -30) val = 0;
@@ -58,23 +58,22 @@ void fsr_task(void *p) {
             converted = process_adc_value(avg, AXIS_FSR);
 
             uint8_t current_code;
-            if (converted < 0x1B)
+            if (converted < settings.fsr_lvl2)
                 current_code = FSR_LVL1;
-            else if (converted < 0x2C)
+            else if (converted < settings.fsr_lvl3)
                 current_code = FSR_LVL2;
             else
                 current_code = FSR_LVL3;
 
-            xQueueSend(xQueueBTN, &current_code, portMAX_DELAY);
+            bus_post_event(EV_SRC_FSR, current_code, 1);
             pressed = true;
             last_sent = current_code;
         } else if (converted == 0 && pressed) {
-            uint8_t release_code = last_sent | 0x80;
-            xQueueSend(xQueueBTN, &release_code, portMAX_DELAY);
+            bus_post_event(EV_SRC_FSR, last_sent, 0);
             pressed = false;
             last_sent = 0;
         }
 
-        vTaskDelay(pdMS_TO_TICKS(40));
+        vTaskDelay(pdMS_TO_TICKS(settings.fsr_period_ms));
     }
 }
@@ -1,81 +1,202 @@
 #include "hc06.h"
+#include "hc06_store.h"
+#include "uart_tx.h"
+#include "uart_rx.h"
+#include "at_engine.h"
 
-bool hc06_check_connection() {
-    char str[32];
-    int i = 0;
-    uart_puts(HC06_UART_ID, "AT");
-    while (uart_is_readable_within_us(HC06_UART_ID, 1000)) {
-        str[i++] = uart_getc(HC06_UART_ID);
-    }
-    str[i] = '\0';
+// Rates the HC-06 supports through AT+BAUD<n>, n = '4' + index
+static const uint hc06_bauds[] = { 9600, 19200, 38400, 57600, 115200 };
+#define HC06_NUM_BAUDS (sizeof(hc06_bauds) / sizeof(hc06_bauds[0]))
 
-    if (strstr(str, "OK") > 0)
-        return true;
-    else
-        return false;
+#define AT_TIMEOUT_MS     300
+#define PROV_MAX_ATTEMPTS 20  // AT exchanges before giving up until the next boot
+
+typedef enum {
+    PROV_DONE = 0,
+    PROV_PROBE,
+    PROV_NAME,
+    PROV_PIN,
+    PROV_BAUD,
+    PROV_VERIFY,
+    PROV_FAILED,
+} prov_state_t;
+
+static uint hc06_baud = HC06_BAUD_RATE;
+static hc06_record_t record;
+
+static prov_state_t state = PROV_DONE;
+static int attempts = 0;
+static int probe_idx = 0;
+
+static const at_port_t hc06_port = {
+    .write = uart_tx_write,
+    .tx_idle = uart_tx_idle,
+};
+
+static void prov_submit(void);
+
+uint hc06_get_baud(void) {
+    return hc06_baud;
 }
 
-bool hc06_set_name(char name[]) {
-    char str[32];
-    int i = 0;
+bool hc06_set_at_mode(int on){
+    gpio_put(HC06_ENABLE_PIN, on);
+    return true;
+}
+
+bool hc06_at_busy(void) {
+    return at_engine_busy();
+}
 
-    sprintf(str, "AT+NAME%s", name);
-    uart_puts(HC06_UART_ID, str);
-    while (uart_is_readable_within_us(HC06_UART_ID, 1000)) {
-        str[i++] = uart_getc(HC06_UART_ID);
+static int baud_index(uint baud) {
+    for (int i = 0; i < HC06_NUM_BAUDS; i++) {
+        if (hc06_bauds[i] == baud)
+            return i;
     }
-    str[i] = '\0';
+    return -1;
+}
 
-    if (strstr(str, "OK") > 0)
-        return true;
-    else
-        return false;
+// The rate can only change once the line is idle, which is exactly when
+// the engine calls this
+static void set_probe_baud(void *ctx) {
+    uart_set_baudrate(HC06_UART_ID, hc06_bauds[probe_idx]);
+}
+
+static void set_known_baud(void *ctx) {
+    uart_set_baudrate(HC06_UART_ID, hc06_baud);
 }
 
-bool hc06_set_pin(char pin[]) {
-    char str[32];
-    int i = 0;
+// Both outcomes are saved: a module that does not answer now would cost
+// every later boot the full PROV_MAX_ATTEMPTS x AT_TIMEOUT_MS again
+static void prov_finish(prov_state_t final) {
+    hc06_set_at_mode(0);
+    state = final;
+    record.baud = hc06_baud;
+    record.flags = final == PROV_DONE ? 0 : HC06_REC_NO_AT;
+    hc06_store_save(&record);
+    if (final == PROV_DONE)
+        printf("hc06 provisioned at %u baud\n", hc06_baud);
+    else
+        printf("hc06 provisioning failed, streaming at %u baud\n", hc06_baud);
+}
 
-    sprintf(str, "AT+PIN%s", pin);
-    uart_puts(HC06_UART_ID, str);
-    while (uart_is_readable_within_us(HC06_UART_ID, 1000)) {
-        str[i++] = uart_getc(HC06_UART_ID);
+static void prov_on_result(bool ok, const char *response, void *ctx) {
+    switch (state) {
+    case PROV_PROBE:
+        if (ok) {
+            hc06_baud = hc06_bauds[probe_idx];
+            state = PROV_NAME;
+        } else {
+            probe_idx = (probe_idx + 1) % HC06_NUM_BAUDS;
+        }
+        break;
+    case PROV_NAME:
+        if (ok)
+            state = PROV_PIN;
+        break;
+    case PROV_PIN:
+        if (ok)
+            state = hc06_baud == HC06_TARGET_BAUD ? PROV_DONE : PROV_BAUD;
+        break;
+    case PROV_BAUD:
+        // The module answers at the old rate and switches right after
+        if (ok) {
+            hc06_baud = HC06_TARGET_BAUD;
+            state = PROV_VERIFY;
+        }
+        break;
+    case PROV_VERIFY:
+        if (ok) {
+            state = PROV_DONE;
+        } else {
+            // Unknown rate now: go back and look for it
+            probe_idx = 0;
+            state = PROV_PROBE;
+        }
+        break;
+    default:
+        break;
     }
-    str[i] = '\0';
 
-    if (strstr(str, "OK") > 0)
-        return true;
+    // Frames in between exchanges go out at the best known rate
+    uart_set_baudrate(HC06_UART_ID, hc06_baud);
+
+    if (state == PROV_DONE)
+        prov_finish(PROV_DONE);
     else
-        return false;
+        prov_submit();
 }
 
-bool hc06_set_at_mode(int on){
-    gpio_put(HC06_ENABLE_PIN, on);
-}
+static void prov_submit(void) {
+    at_command_t cmd = {
+        .expect = "OK",
+        .timeout_ms = AT_TIMEOUT_MS,
+        .on_send = set_known_baud,
+        .done = prov_on_result,
+    };
 
-bool hc06_init(char name[], char pin[]) {
-    hc06_set_at_mode(1);
-    printf("check connection\n");
-    while (hc06_check_connection() == false) {
-        printf("not connected\n");
-        vTaskDelay(pdMS_TO_TICKS(1000));
+    if (attempts++ >= PROV_MAX_ATTEMPTS) {
+        prov_finish(PROV_FAILED);
+        return;
     }
-    printf("Connected \n");
 
-    vTaskDelay(pdMS_TO_TICKS(1000));
-    printf("set name\n");
-    while (hc06_set_name(name) == false) {
-        printf("set name failed\n");
-        vTaskDelay(pdMS_TO_TICKS(1000));
+    switch (state) {
+    case PROV_PROBE:
+        strcpy(cmd.cmd, "AT");
+        cmd.on_send = set_probe_baud;
+        break;
+    case PROV_NAME:
+        snprintf(cmd.cmd, sizeof(cmd.cmd), "AT+NAME%s", record.name);
+        break;
+    case PROV_PIN:
+        snprintf(cmd.cmd, sizeof(cmd.cmd), "AT+PIN%s", record.pin);
+        break;
+    case PROV_BAUD:
+        snprintf(cmd.cmd, sizeof(cmd.cmd), "AT+BAUD%c", '4' + baud_index(HC06_TARGET_BAUD));
+        break;
+    case PROV_VERIFY:
+        strcpy(cmd.cmd, "AT");
+        break;
+    default:
+        return;
     }
-    printf("name ok\n");
+    at_engine_submit(&cmd);
+}
+
+// Picks the rate to open the UART with and queues provisioning if it is
+// needed. Never touches the UART, so data can flow right away.
+uint hc06_start(const char *name, const char *pin) {
+    hc06_record_t stored;
+    bool have_record = hc06_store_load(&stored);
+
+    memset(&record, 0, sizeof(record));
+    strncpy(record.name, name, sizeof(record.name) - 1);
+    strncpy(record.pin, pin, sizeof(record.pin) - 1);
+    record.baud = HC06_TARGET_BAUD;
+
+    if (have_record)
+        hc06_baud = stored.baud;
 
-    vTaskDelay(pdMS_TO_TICKS(1000));
-    printf("set pin\n");
-    while (hc06_set_pin(pin) == false) {
-        printf("set pin failed\n");
-        vTaskDelay(pdMS_TO_TICKS(1000));
+    at_engine_init(&hc06_port);
+    uart_rx_set_hook(at_engine_rx_from_isr);
+
+    // A new name or PIN in the firmware provisions again, even after a
+    // failed attempt
+    if (have_record && (stored.baud == HC06_TARGET_BAUD || (stored.flags & HC06_REC_NO_AT)) &&
+        strcmp(stored.name, record.name) == 0 && strcmp(stored.pin, record.pin) == 0) {
+        state = PROV_DONE;
+    } else {
+        state = PROV_PROBE;
+        probe_idx = 0;
+        attempts = 0;
+        hc06_set_at_mode(1);
+        prov_submit();
     }
-    printf("pin ok\n");
-    hc06_set_at_mode(0);
+    return hc06_baud;
+}
+
+// Advances provisioning without blocking. Returns how long the caller can
+// sleep before calling again.
+TickType_t hc06_poll(void) {
+    return at_engine_poll();
 }
@@ -12,16 +12,25 @@
 #include <stdio.h>
 
 #define HC06_UART_ID uart1
-#define HC06_BAUD_RATE 9600
-#define HC06_RX_PIN 4
-#define HC06_TX_PIN 5
+#define HC06_BAUD_RATE 9600      // factory default, used until probing finds the real rate
+#define HC06_TARGET_BAUD 115200
+#define HC06_TX_PIN 4
+#define HC06_RX_PIN 5
 #define HC06_ENABLE_PIN 6
+// STATE output of the breakout, high while a host is connected. Pulled
+// up, so an unconnected pin reads as "connected"; -1 disables it.
+#define HC06_STATE_PIN 2
 
-bool hc06_check_connection();
-bool hc06_set_name(char name[]);
-bool hc06_set_pin(char pin[]);
+#define HC06_NAME "ARCADESTICK"
+#define HC06_PIN  "1234"
+
+// Provisioning (name, pin, baud) runs in the background from hc06_poll().
+// Once it succeeds a record is kept in flash and later boots skip it.
+uint hc06_start(const char *name, const char *pin);
+TickType_t hc06_poll(void);
+bool hc06_at_busy(void);
 bool hc06_set_at_mode(int on);
-bool hc06_init(char name[], char pin[]);
+uint hc06_get_baud(void);
 
 
 #endif // HC06_H_
@@ -0,0 +1,39 @@
+#include "hc06_store.h"
+#include "protocol.h"
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include <stddef.h>
+#include <string.h>
+
+#define HC06_STORE_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE)
+#define HC06_STORE_MAGIC  0x48433036  // "HC06"
+
+static uint8_t record_crc(const hc06_record_t *rec) {
+    return proto_crc8((const uint8_t *)rec, offsetof(hc06_record_t, crc));
+}
+
+bool hc06_store_load(hc06_record_t *rec) {
+    const hc06_record_t *flash = (const hc06_record_t *)(XIP_BASE + HC06_STORE_OFFSET);
+
+    if (flash->magic != HC06_STORE_MAGIC || flash->crc != record_crc(flash))
+        return false;
+    *rec = *flash;
+    return true;
+}
+
+// Erasing a sector takes tens of ms with interrupts off, so this only runs
+// once, when provisioning ends (done or given up).
+void hc06_store_save(hc06_record_t *rec) {
+    static uint8_t page[FLASH_PAGE_SIZE];
+
+    rec->magic = HC06_STORE_MAGIC;
+    rec->crc = record_crc(rec);
+    memset(page, 0xFF, sizeof(page));
+    memcpy(page, rec, sizeof(*rec));
+
+    uint32_t ints = save_and_disable_interrupts();
+    flash_range_erase(HC06_STORE_OFFSET, FLASH_SECTOR_SIZE);
+    flash_range_program(HC06_STORE_OFFSET, page, FLASH_PAGE_SIZE);
+    restore_interrupts(ints);
+}
@@ -0,0 +1,24 @@
+#ifndef HC06_STORE_H
+#define HC06_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// The module never answered AT (already paired, AT pin not wired): later
+// boots stream at the stored rate without trying again
+#define HC06_REC_NO_AT 0x01
+
+// "Provisioned with name/pin X at baud Y", kept in the last flash sector
+typedef struct {
+    uint32_t magic;
+    uint32_t baud;
+    char name[21];
+    char pin[5];
+    uint8_t flags;  // HC06_REC_*
+    uint8_t crc;
+} hc06_record_t;
+
+bool hc06_store_load(hc06_record_t *rec);
+void hc06_store_save(hc06_record_t *rec);
+
+#endif
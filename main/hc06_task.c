@@ -1,39 +1,679 @@
 #include "hc06_task.h"
 #include "common.h"
 #include "hc06.h"
-#include "hardware/uart.h"
-#include "hardware/gpio.h"
+#include "command.h"
+#include "protocol.h"
+#include "transport.h"
+#include "event_bus.h"
+#include "settings.h"
+#include "analog_pack.h"
+#include "batch_window.h"
+#include "pico/time.h"
 #include "FreeRTOS.h"
 #include "queue.h"
 #include "task.h"
 
-extern QueueHandle_t xQueueADC;
-extern QueueHandle_t xQueueBTN;
+#define EDGE_QUEUE_LEN   10
+#define ANALOG_QUEUE_LEN 10
+#define CONTROL_QUEUE_LEN 4
+
+// Worst case on the wire, with FEC parity
+#define TX_FRAME_SIZE   (PROTO_FRAME_EVENT_TIMED_LEN + 3 + PROTO_FEC_LEN)
+#define TX_CONTROL_SIZE (1 + HC06_CONTROL_MAX + 3 + PROTO_FEC_LEN)
+#define TX_HEARTBEAT_SIZE (PROTO_FRAME_HEARTBEAT_LEN + 3 + PROTO_FEC_LEN)
+#define TX_STATE_SIZE   (PROTO_FRAME_STATE_LEN + 3 + PROTO_FEC_LEN)
+
+// Full-state frames go out only on an otherwise idle pass. The interval
+// doubles while the link carries events and halves while it is quiet.
+#define RESYNC_MIN_MS 250
+#define RESYNC_MAX_MS 2000
+
+// Edge frames stay in a small window until the host ACKs them. The first
+// copy goes out immediately, so a clean link sees no extra latency.
+#define RETX_WINDOW     8
+#define RETX_TIMEOUT_MS 100
+#define RETX_MAX_TRIES  4
+
+// Latency probes, only while batching is enabled
+#define PROBE_INTERVAL_MS 1000
+#define TX_PROBE_SIZE (PROTO_FRAME_PROBE_LEN + 3 + PROTO_FEC_LEN)
+
+typedef struct {
+    uint8_t len;
+    uint8_t data[HC06_CONTROL_MAX];
+} control_msg_t;
+
+// Edges and analog updates get separate queues so buttons keep priority
+static bus_subscriber_t edge_sub;
+static bus_subscriber_t analog_sub;
+static event_t edge_storage[EDGE_QUEUE_LEN];
+static event_t analog_storage[ANALOG_QUEUE_LEN];
+
+// Replies from command_task; only this task writes to the transports
+static QueueHandle_t control_queue;
+static StaticQueue_t control_queue_buffer;
+static control_msg_t control_storage[CONTROL_QUEUE_LEN];
+static TaskHandle_t tx_task = NULL;
+static volatile bool resync_requested = false;
+
+typedef struct {
+    bool used;
+    uint8_t seq;
+    uint8_t tries;
+    TickType_t sent;
+    event_t ev;
+} retx_entry_t;
+
+// Shared with command_task (hc06_task_ack), guarded by a critical section
+static retx_entry_t retx[RETX_WINDOW];
+static volatile bool host_acks = false;
+static uint32_t retransmits = 0;
+
+static uint8_t tx_seq = 0;
+// One batch always fits every queue
+static uint8_t edge_buffer[(EDGE_QUEUE_LEN + RETX_WINDOW) * TX_FRAME_SIZE];
+static uint8_t tx_buffer[ANALOG_QUEUE_LEN * TX_FRAME_SIZE + CONTROL_QUEUE_LEN * TX_CONTROL_SIZE +
+                         TX_PROBE_SIZE];
+// Compact analog updates waiting to share a frame
+static analog_pack_t analog_pack;
+static volatile bool analog_key_needed = true;
+// Adaptive batching window (batch_window.h)
+static batch_window_t batch;
+// Worst time an edge spent on the bus before reaching a transport
+static uint32_t edge_latency_max = 0;
+
+// Every frame this task sends goes through here
+static size_t encode_frame(const uint8_t *payload, size_t len, uint8_t *out) {
+    if (settings.wire_format & PROTO_FMT_FEC)
+        return proto_encode_frame_fec(payload, len, out);
+    return proto_encode_frame(payload, len, out);
+}
+
+static size_t encode_event_seq(uint8_t *out, const event_t *ev, uint8_t seq) {
+    uint8_t payload[PROTO_FRAME_EVENT_TIMED_LEN];
+    uint8_t code = ev->code;
+    int16_t value = ev->value;
+
+    if (ev->source == EV_SRC_POT)
+        return encode_frame(payload, proto_pack_event(payload, seq, code, value), out);
+
+    // Wire format: edges are code / code | 0x80 with a fixed value
+    if (ev->value == 0)
+        code |= 0x80;
+    value = 0x0064;
+
+    if (!(settings.wire_format & PROTO_FMT_EDGE_TIME))
+        return encode_frame(payload, proto_pack_event(payload, seq, code, value), out);
+
+    // The host maps at_us to its own clock (PROTO_CMD_TIME) to split the
+    // latency between device, link and host
+    uint32_t queued = time_us_32() - ev->timestamp;
+    size_t len = proto_pack_event_timed(payload, seq, code, value, ev->timestamp,
+                                        queued > 0xFFFF ? 0xFFFF : queued);
+    return encode_frame(payload, len, out);
+}
+
+static size_t encode_event(uint8_t *out, const event_t *ev) {
+    return encode_event_seq(out, ev, tx_seq++);
+}
+
+// Sends an edge and keeps a copy until it is ACKed. Without ACKs from
+// the host (older script) edges stay fire-and-forget.
+static size_t encode_edge(uint8_t *out, const event_t *ev, TickType_t now) {
+    uint8_t seq = tx_seq;
+    size_t len = encode_event(out, ev);
+
+    if (!host_acks)
+        return len;
+
+    taskENTER_CRITICAL();
+    int slot = 0;
+    for (int i = 0; i < RETX_WINDOW; i++) {
+        if (!retx[i].used) {
+            slot = i;
+            break;
+        }
+        if ((uint8_t)(retx[i].seq - seq) < (uint8_t)(retx[slot].seq - seq))
+            slot = i;  // oldest entry
+    }
+    bool evicted = retx[slot].used;
+    retx[slot].used = true;
+    retx[slot].seq = seq;
+    retx[slot].tries = 0;
+    retx[slot].sent = now;
+    retx[slot].ev = *ev;
+    taskEXIT_CRITICAL();
+
+    // The window was full: the state frame repairs whatever gets lost
+    if (evicted)
+        resync_requested = true;
+    return len;
+}
+
+// Re-sends timed out edges with their original seq so the host can drop
+// copies it already has. Returns the bytes written to out.
+static size_t retransmit_edges(uint8_t *out, size_t room, TickType_t now, TickType_t *next) {
+    TickType_t timeout = pdMS_TO_TICKS(RETX_TIMEOUT_MS);
+    size_t len = 0;
+
+    taskENTER_CRITICAL();
+    for (int i = 0; i < RETX_WINDOW; i++) {
+        if (!retx[i].used)
+            continue;
+        TickType_t age = now - retx[i].sent;
+        if (age < timeout) {
+            if (timeout - age < *next)
+                *next = timeout - age;
+            continue;
+        }
+        if (retx[i].tries >= RETX_MAX_TRIES) {
+            // Give up on this edge and let a state frame fix the host
+            retx[i].used = false;
+            resync_requested = true;
+            continue;
+        }
+        if (len + TX_FRAME_SIZE > room) {
+            *next = 1;
+            continue;
+        }
+        len += encode_event_seq(&out[len], &retx[i].ev, retx[i].seq);
+        retx[i].tries++;
+        retx[i].sent = now;
+        retransmits++;
+        if (timeout < *next)
+            *next = timeout;
+    }
+    taskEXIT_CRITICAL();
+    return len;
+}
+
+void hc06_task_ack(uint8_t seq, uint8_t mask) {
+    host_acks = true;
+
+    taskENTER_CRITICAL();
+    for (int i = 0; i < RETX_WINDOW; i++) {
+        uint8_t d = seq - retx[i].seq;
+        if (retx[i].used && (d == 0 || (d <= 8 && (mask & (1u << (d - 1))))))
+            retx[i].used = false;
+    }
+    taskEXIT_CRITICAL();
+}
+
+uint32_t hc06_task_retransmits(void) {
+    return retransmits;
+}
+
+uint32_t hc06_task_edge_latency_max(void) {
+    return edge_latency_max;
+}
+
+static void drain_events(void) {
+    event_t ev;
+
+    while (bus_receive(&edge_sub, &ev, 0))
+        ;
+    while (bus_receive(&analog_sub, &ev, 0))
+        ;
+    edge_sub.overflowed = false;
+}
+
+// No host is listening: queued input would only come out as stale events
+// after a reconnect. The bus keeps the current state, which goes out as a
+// single state frame once a link is back.
+static void discard_pending(void) {
+    control_msg_t msg;
+
+    drain_events();
+    while (xQueueReceive(control_queue, &msg, 0))
+        ;
+
+    taskENTER_CRITICAL();
+    for (int i = 0; i < RETX_WINDOW; i++)
+        retx[i].used = false;
+    taskEXIT_CRITICAL();
+}
+
+// Moves pot updates from the bus into analog_pack and sends them as
+// compact records once a frame is due (full, or held long enough).
+// *next is lowered to when the held updates have to go out.
+static size_t encode_analog(uint8_t *out, size_t room, TickType_t *next) {
+    uint8_t payload[PROTO_MAX_PAYLOAD];
+    size_t len = 0;
+    event_t ev;
+
+    if (analog_key_needed) {
+        analog_key_needed = false;
+        analog_pack_key(&analog_pack);
+    }
+
+    uint32_t hold_us = settings.analog_hold_ms * 1000u;
+    while (len + PROTO_MAX_FRAME_FEC <= room) {
+        while (!analog_pack_full(&analog_pack) && bus_receive(&analog_sub, &ev, 0))
+            analog_pack_add(&analog_pack, ev.code & 0x0F, ev.value, ev.timestamp);
+        if (!analog_pack_due(&analog_pack, time_us_32(), hold_us))
+            break;
+        payload[0] = tx_seq++;
+        size_t plen = 1 + analog_pack_records(&analog_pack, &payload[1], sizeof(payload) - 1);
+        len += encode_frame(payload, plen, &out[len]);
+    }
+
+    if (analog_pack.count > 0) {
+        uint32_t waited = time_us_32() - analog_pack.first_us;
+        TickType_t left = waited >= hold_us ? 1 : pdMS_TO_TICKS((hold_us - waited) / 1000) + 1;
+        if (left < *next)
+            *next = left;
+    }
+    return len;
+}
+
+static size_t encode_control(uint8_t *out, const control_msg_t *msg) {
+    uint8_t payload[1 + HC06_CONTROL_MAX];
+
+    payload[0] = tx_seq++;
+    for (int i = 0; i < msg->len; i++)
+        payload[1 + i] = msg->data[i];
+
+    // Clock sync replies are stamped as late as possible, right before
+    // they join the TX lane
+    if (msg->data[0] == PROTO_CODE_TIME && 1 + msg->len == PROTO_FRAME_TIME_LEN) {
+        uint32_t now = time_us_32();
+        payload[PROTO_FRAME_TIME_LEN - 4] = (now >> 24) & 0xFF;
+        payload[PROTO_FRAME_TIME_LEN - 3] = (now >> 16) & 0xFF;
+        payload[PROTO_FRAME_TIME_LEN - 2] = (now >> 8) & 0xFF;
+        payload[PROTO_FRAME_TIME_LEN - 1] = now & 0xFF;
+    }
+    return encode_frame(payload, 1 + msg->len, out);
+}
+
+bool hc06_task_send_control(const uint8_t *payload, size_t len) {
+    control_msg_t msg;
+
+    if (len > HC06_CONTROL_MAX)
+        return false;
+
+    msg.len = len;
+    for (size_t i = 0; i < len; i++)
+        msg.data[i] = payload[i];
+    if (xQueueSend(control_queue, &msg, 0) != pdTRUE)
+        return false;
+
+    if (tx_task != NULL)
+        xTaskNotifyGive(tx_task);
+    return true;
+}
+
+static size_t encode_heartbeat(uint8_t *out) {
+    uint8_t payload[PROTO_FRAME_HEARTBEAT_LEN];
+    return encode_frame(payload, proto_pack_heartbeat(payload, tx_seq++), out);
+}
+
+// latched: edge codes to report as pressed on top of the current state
+static size_t encode_state(uint8_t *out, uint16_t latched) {
+    input_state_t st;
+    uint8_t payload[PROTO_FRAME_STATE_LEN];
+    uint8_t fsr = 0;
+
+    bus_get_state(&st);
+    st.pressed |= latched;
+    for (uint8_t code = 0x06; code <= 0x08; code++) {
+        if (st.pressed & (1u << code))
+            fsr = code;
+    }
+
+    size_t len = proto_pack_state(payload, tx_seq++, st.pressed, fsr, st.pot);
+    return encode_frame(payload, len, out);
+}
+
+void hc06_task_request_resync(void) {
+    resync_requested = true;
+    analog_key_needed = true;
+    if (tx_task != NULL)
+        xTaskNotifyGive(tx_task);
+}
+
+void hc06_task_init(void) {
+    control_queue = xQueueCreateStatic(CONTROL_QUEUE_LEN, sizeof(control_msg_t),
+                                       (uint8_t *)control_storage, &control_queue_buffer);
+    bus_subscribe(&edge_sub, EV_MASK(EV_SRC_BUTTON) | EV_MASK(EV_SRC_FSR),
+                  edge_storage, EDGE_QUEUE_LEN);
+    bus_subscribe(&analog_sub, EV_MASK(EV_SRC_POT), analog_storage, ANALOG_QUEUE_LEN);
+    analog_pack_init(&analog_pack);
+    batch_window_init(&batch);
+}
+
+// Fixed-interval reports. A hardware alarm wakes this task every
+// settings.report_ms and each wakeup sends the bus state at that instant,
+// so the host sees input at a steady rate instead of whenever events
+// happen to arrive.
+static repeating_timer_t report_timer;
+static uint8_t report_ms = 0;
+static volatile bool report_due = false;
+static uint16_t report_latched;  // edge codes pressed since the last report
+static uint32_t report_last_us;
+static uint64_t report_sum_us;
+static uint32_t report_count;
+static uint32_t report_jitter_max;
+
+static bool report_tick(repeating_timer_t *t) {
+    BaseType_t woken = pdFALSE;
+
+    (void)t;
+    report_due = true;
+    vTaskNotifyGiveFromISR(tx_task, &woken);
+    portYIELD_FROM_ISR(woken);
+    return true;
+}
+
+// Starts, stops or retimes the alarm when the host changed report_ms
+static void report_update(void) {
+    if (settings.report_ms == report_ms)
+        return;
+
+    if (report_ms != 0)
+        cancel_repeating_timer(&report_timer);
+    report_ms = settings.report_ms;
+    report_latched = 0;
+
+    // Edges sent before the switch would be retransmitted after the
+    // state that already covers them
+    taskENTER_CRITICAL();
+    report_count = 0;
+    report_sum_us = 0;
+    report_jitter_max = 0;
+    for (int i = 0; i < RETX_WINDOW; i++)
+        retx[i].used = false;
+    taskEXIT_CRITICAL();
+
+    if (report_ms != 0) {
+        // Reports replace the event frames: nothing needs waking per event
+        edge_sub.notify = NULL;
+        analog_sub.notify = NULL;
+        drain_events();
+        report_due = false;
+        // Negative delay: fixed rate from one alarm to the next
+        add_repeating_timer_us(-(int64_t)report_ms * 1000, report_tick, NULL, &report_timer);
+    } else {
+        edge_sub.notify = tx_task;
+        analog_sub.notify = tx_task;
+        hc06_task_request_resync();
+    }
+}
+
+// Period and jitter are measured where the report is handed to the
+// links, which includes the task wakeup latency, not at the alarm
+static void report_sent(void) {
+    uint32_t now = time_us_32();
+
+    taskENTER_CRITICAL();
+    if (report_count > 0) {
+        uint32_t period = now - report_last_us;
+        uint32_t nominal = report_ms * 1000u;
+        uint32_t dev = period > nominal ? period - nominal : nominal - period;
+        report_sum_us += period;
+        if (dev > report_jitter_max)
+            report_jitter_max = dev;
+    }
+    report_count++;
+    report_last_us = now;
+    taskEXIT_CRITICAL();
+}
+
+void hc06_task_report_stats(uint32_t *period_us, uint32_t *jitter_us) {
+    taskENTER_CRITICAL();
+    *period_us = report_count > 1 ? report_sum_us / (report_count - 1) : 0;
+    *jitter_us = report_jitter_max;
+    taskEXIT_CRITICAL();
+}
+
+// One pass in fixed-interval mode: the state report on the edge lane,
+// replies on the bulk lane. Individual events are not sent; the state
+// already reflects them. Reports can be further apart than the button
+// scan, so a press that was released again before the report is latched
+// and goes out as pressed in that report and released in the next.
+static void report_pass(void) {
+    uint8_t frame[TX_STATE_SIZE];
+    control_msg_t msg;
+    event_t ev;
+    size_t len = 0;
+
+    while (bus_receive(&edge_sub, &ev, 0)) {
+        if (ev.value != 0 && ev.code < 16)
+            report_latched |= 1u << ev.code;
+    }
+    while (bus_receive(&analog_sub, &ev, 0))
+        ;
+    edge_sub.overflowed = false;
+
+    if (report_due) {
+        report_due = false;
+        if (transport_room(TRANSPORT_LANE_EDGE) >= TX_STATE_SIZE &&
+            transport_send(TRANSPORT_LANE_EDGE, frame, encode_state(frame, report_latched), 0)) {
+            report_latched = 0;
+            report_sent();
+        }
+    }
+
+    size_t room = transport_room(TRANSPORT_LANE_BULK);
+    if (room > sizeof(tx_buffer))
+        room = sizeof(tx_buffer);
+    while (len + TX_CONTROL_SIZE <= room && xQueueReceive(control_queue, &msg, 0))
+        len += encode_control(&tx_buffer[len], &msg);
+    if (len > 0)
+        transport_send(TRANSPORT_LANE_BULK, tx_buffer, len, 0);
+}
+
+// Probe echoes drive the batching window, capped at settings.batch_limit_ms
+void hc06_task_echo(uint32_t at_us, uint16_t packet_us) {
+    uint32_t rtt = time_us_32() - at_us;
+
+    taskENTER_CRITICAL();
+    batch_window_probe(&batch, rtt, packet_us, settings.batch_limit_ms * 1000u);
+    taskEXIT_CRITICAL();
+}
+
+void hc06_task_batch_stats(uint32_t *window_us, uint32_t *rtt_us) {
+    taskENTER_CRITICAL();
+    *window_us = settings.batch_limit_ms ? batch.window_us : 0;
+    *rtt_us = batch.rtt_us;
+    taskEXIT_CRITICAL();
+}
+
+// The window is a few ms, under one 10 ms tick, so a one-shot hardware
+// alarm wakes this task when it closes
+static alarm_id_t batch_alarm = 0;
+
+static int64_t batch_expired(alarm_id_t id, void *user_data) {
+    BaseType_t woken = pdFALSE;
+
+    (void)id;
+    (void)user_data;
+    vTaskNotifyGiveFromISR(tx_task, &woken);
+    portYIELD_FROM_ISR(woken);
+    return 0;
+}
+
+// Stamped right before it joins the TX lane, so batching and queueing on
+// this side do not count as link latency
+static size_t encode_probe(uint8_t *out) {
+    uint8_t payload[PROTO_FRAME_PROBE_LEN];
+    return encode_frame(payload, proto_pack_probe(payload, tx_seq++, time_us_32()), out);
+}
 
 void hc06C_task(void *p) {
-    uart_init(HC06_UART_ID, HC06_BAUD_RATE);
-    gpio_set_function(HC06_TX_PIN, GPIO_FUNC_UART);
-    gpio_set_function(HC06_RX_PIN, GPIO_FUNC_UART);
-    hc06_init("ARCADESTICK", "1234");
+    (void)p;
+    tx_task = xTaskGetCurrentTaskHandle();
+    edge_sub.notify = tx_task;
+    analog_sub.notify = tx_task;
 
-    adc_data_t data;
-    uint8_t code;
-    uint8_t buffer[4];
+    transport_start_all();
+
+    event_t ev;
+    control_msg_t msg;
+    TickType_t wait = 0;
+    TickType_t last_tx = xTaskGetTickCount();
+    TickType_t last_resync = last_tx;
+    TickType_t resync_interval = pdMS_TO_TICKS(RESYNC_MIN_MS);
+    bool busy_since_resync = false;
+    TickType_t last_probe = last_tx;
+    uint32_t batch_start_us = 0;
+    bool batch_open = false;
 
     while (1) {
-        if (xQueueReceive(xQueueBTN, &code, 0)) {
-            buffer[0] = code;
-            buffer[1] = 0x00;
-            buffer[2] = 0x64;
-            buffer[3] = 0xFF;
-            uart_write_blocking(HC06_UART_ID, buffer, 4);
-        } else if (xQueueReceive(xQueueADC, &data, 0)) {
-            buffer[0] = data.axis;
-            buffer[1] = (data.value >> 8) & 0xFF;
-            buffer[2] = data.value & 0xFF;
-            buffer[3] = 0xFF;
-            uart_write_blocking(HC06_UART_ID, buffer, 4);
-        }
-        vTaskDelay(pdMS_TO_TICKS(10));
+        // Sleep until the bus delivers something or provisioning needs to
+        // run. Events posted before this task started are picked up on the
+        // first pass.
+        ulTaskNotifyTake(pdTRUE, wait);
+
+        // Links that are down (no Bluetooth host, HC-06 busy with AT
+        // commands) are skipped by the fan-out
+        TickType_t prov_wait = transport_poll_all();
+        if (!transport_any_ready()) {
+            discard_pending();
+            wait = prov_wait;
+            continue;
+        }
+        if (transport_reconnected()) {
+            // A fresh state frame instead of replaying what was missed.
+            // The HELLO queued at boot was discarded with no link up, and
+            // a host still expecting FEC only accepts a HELLO without it.
+            command_announce();
+            resync_requested = true;
+            analog_key_needed = true;
+        }
+
+        report_update();
+        if (report_ms != 0) {
+            report_pass();
+            // The alarm and hc06_task_send_control() wake this task
+            wait = uxQueueMessagesWaiting(control_queue) ? pdMS_TO_TICKS(10) : prov_wait;
+            continue;
+        }
+
+        TickType_t now = xTaskGetTickCount();
+
+        // Batching: the first event waits for the window to close, unless
+        // its queue is about to overflow
+        uint32_t window_us = settings.batch_limit_ms ? batch.window_us : 0;
+        bool events = uxQueueMessagesWaiting(edge_sub.queue) || uxQueueMessagesWaiting(analog_sub.queue);
+        if (window_us > 0 && events && uxQueueSpacesAvailable(edge_sub.queue) > 2) {
+            uint32_t now_us = time_us_32();
+            if (!batch_open) {
+                batch_open = true;
+                batch_start_us = now_us;
+                batch_alarm = add_alarm_in_us(window_us, batch_expired, NULL, false);
+            }
+            uint32_t waited = now_us - batch_start_us;
+            if (waited < window_us) {
+                // The tick timeout only backs up the alarm
+                wait = pdMS_TO_TICKS((window_us - waited) / 1000) + 1;
+                continue;
+            }
+        }
+        if (batch_alarm > 0)
+            cancel_alarm(batch_alarm);
+        batch_alarm = 0;
+        batch_open = false;
+
+        // Edges (and their retransmits) go to their own lane, which the
+        // backends serve ahead of everything else
+        size_t edge_len = 0;
+        size_t edge_room = transport_room(TRANSPORT_LANE_EDGE);
+        if (edge_room > sizeof(edge_buffer))
+            edge_room = sizeof(edge_buffer);
+        bool edge_backlog = transport_pending(TRANSPORT_LANE_EDGE) > 0;
+
+        TickType_t retx_wait = portMAX_DELAY;
+        uint32_t oldest = 0;
+        while (edge_len + TX_FRAME_SIZE <= edge_room && bus_receive(&edge_sub, &ev, 0)) {
+            uint32_t queued = time_us_32() - ev.timestamp;
+            if (queued > edge_latency_max)
+                edge_latency_max = queued;
+            if (oldest == 0)
+                oldest = ev.timestamp;
+            edge_len += encode_edge(&edge_buffer[edge_len], &ev, now);
+        }
+        edge_len += retransmit_edges(&edge_buffer[edge_len], edge_room - edge_len, now, &retx_wait);
+        if (edge_len > 0 && transport_send(TRANSPORT_LANE_EDGE, edge_buffer, edge_len, oldest))
+            last_tx = now;
+
+        // Everything else shares the bulk lane. Events that do not fit
+        // stay queued for the next wakeup; while edges are backed up, pot
+        // updates stay on the bus where they coalesce.
+        size_t len = 0;
+        size_t room = transport_room(TRANSPORT_LANE_BULK);
+        if (room > sizeof(tx_buffer))
+            room = sizeof(tx_buffer);
+        while (len + TX_CONTROL_SIZE <= room && xQueueReceive(control_queue, &msg, 0))
+            len += encode_control(&tx_buffer[len], &msg);
+        if (settings.batch_limit_ms && now - last_probe >= pdMS_TO_TICKS(PROBE_INTERVAL_MS) &&
+            len + TX_PROBE_SIZE <= room) {
+            len += encode_probe(&tx_buffer[len]);
+            last_probe = now;
+        }
+        TickType_t analog_wait = portMAX_DELAY;
+        if (!(settings.wire_format & PROTO_FMT_COMPACT_ANALOG)) {
+            // Held compact updates are older than what the bus has now
+            analog_pack.count = 0;
+            while (!edge_backlog && len + TX_FRAME_SIZE <= room && bus_receive(&analog_sub, &ev, 0))
+                len += encode_event(&tx_buffer[len], &ev);
+        } else if (!edge_backlog) {
+            len += encode_analog(&tx_buffer[len], room - len, &analog_wait);
+        }
+
+        TickType_t heartbeat = pdMS_TO_TICKS(settings.heartbeat_ms);
+        if (len > 0 || edge_len > 0)
+            busy_since_resync = true;
+
+        // Dropped edges mean the host is out of sync; the counts go out
+        // in STATS (BTN_DROPS, FSR_DROPS)
+        if (edge_sub.overflowed) {
+            edge_sub.overflowed = false;
+            resync_requested = true;
+        }
+
+        // Full state only goes out when nothing else is waiting and every
+        // link is drained, so it never delays an event
+        bool resync_due = resync_requested || now - last_resync >= resync_interval;
+        if (len == 0 && edge_len == 0 && resync_due && room >= TX_STATE_SIZE && transport_idle()) {
+            len = encode_state(tx_buffer, 0);
+            resync_requested = false;
+            last_resync = now;
+            if (busy_since_resync)
+                resync_interval *= 2;
+            else
+                resync_interval /= 2;
+            if (resync_interval > pdMS_TO_TICKS(RESYNC_MAX_MS))
+                resync_interval = pdMS_TO_TICKS(RESYNC_MAX_MS);
+            if (resync_interval < pdMS_TO_TICKS(RESYNC_MIN_MS))
+                resync_interval = pdMS_TO_TICKS(RESYNC_MIN_MS);
+            busy_since_resync = false;
+        }
+
+        // Lets the host tell a quiet stick from a dead link
+        if (len == 0 && edge_len == 0 && now - last_tx >= heartbeat && room >= TX_HEARTBEAT_SIZE)
+            len = encode_heartbeat(tx_buffer);
+
+        if (len > 0 && transport_send(TRANSPORT_LANE_BULK, tx_buffer, len, 0))
+            last_tx = now;
+
+        // Leftovers mean the links were full: retry once it had time to drain
+        if (uxQueueMessagesWaiting(edge_sub.queue) || uxQueueMessagesWaiting(analog_sub.queue) ||
+            uxQueueMessagesWaiting(control_queue))
+            wait = pdMS_TO_TICKS(10);
+        else if (now - last_tx >= heartbeat || resync_requested)
+            wait = 1;
+        else
+            wait = heartbeat - (now - last_tx);
+        if (now - last_resync < resync_interval && resync_interval - (now - last_resync) < wait)
+            wait = resync_interval - (now - last_resync);
+        if (settings.batch_limit_ms && now - last_probe < pdMS_TO_TICKS(PROBE_INTERVAL_MS) &&
+            pdMS_TO_TICKS(PROBE_INTERVAL_MS) - (now - last_probe) < wait)
+            wait = pdMS_TO_TICKS(PROBE_INTERVAL_MS) - (now - last_probe);
+        if (analog_wait < wait)
+            wait = analog_wait;
+        if (retx_wait < wait)
+            wait = retx_wait;
+        if (prov_wait < wait)
+            wait = prov_wait;
     }
 }
@@ -1,6 +1,35 @@
 #ifndef HC06_TASK_H
 #define HC06_TASK_H
 
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Subscribes the transport to the event bus; call before the scheduler starts
+void hc06_task_init(void);
 void hc06C_task(void *p);
 
+// Queues a control reply ([code, data...], without seq) for the host
+#define HC06_CONTROL_MAX 31
+bool hc06_task_send_control(const uint8_t *payload, size_t len);
+
+// Sends a full-state frame as soon as the link is idle
+void hc06_task_request_resync(void);
+
+// Selective ACK from the host for edge frames (PROTO_CMD_ACK)
+void hc06_task_ack(uint8_t seq, uint8_t mask);
+uint32_t hc06_task_retransmits(void);
+
+// Worst edge latency from bus_post to the TX ring, in us
+uint32_t hc06_task_edge_latency_max(void);
+
+// Fixed-interval reports (settings.report_ms): mean period and worst
+// deviation from it, in us, since the interval last changed
+void hc06_task_report_stats(uint32_t *period_us, uint32_t *jitter_us);
+
+// Host echo of a PROTO_CODE_PROBE (PROTO_CMD_ECHO), with the radio packet
+// interval the host sees; feeds the batching window
+void hc06_task_echo(uint32_t at_us, uint16_t packet_us);
+void hc06_task_batch_stats(uint32_t *window_us, uint32_t *rtt_us);
+
 #endif
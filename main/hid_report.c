@@ -0,0 +1,19 @@
+#include <string.h>
+#include "hid_report.h"
+#include "common.h"
+
+void hid_pack_report(const input_state_t *st, hid_report_t *report) {
+    memset(report, 0, sizeof(*report));
+    report->buttons = st->pressed >> 1;
+
+    report->z = -127;
+    if (st->pressed & (1u << (AXIS_FSR + 2)))
+        report->z = 127;
+    else if (st->pressed & (1u << (AXIS_FSR + 1)))
+        report->z = 42;
+    else if (st->pressed & (1u << AXIS_FSR))
+        report->z = -42;
+
+    int pot = st->pot - 128;
+    report->rx = pot < -127 ? -127 : pot > 127 ? 127 : pot;
+}
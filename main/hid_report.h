@@ -0,0 +1,54 @@
+#ifndef HID_REPORT_H
+#define HID_REPORT_H
+
+#include <stdint.h>
+#include "event_bus.h"
+
+// Gamepad input report, same layout as TinyUSB's hid_gamepad_report_t
+// but owned here so the descriptor and the packing can be tested
+// without the USB stack
+typedef struct __attribute__((packed)) {
+    int8_t x, y, z, rz, rx, ry;  // -127..127
+    uint8_t hat;                 // 0 centered, 1-8 clockwise from up
+    uint32_t buttons;            // bit n is button n + 1
+} hid_report_t;
+
+// Report descriptor matching hid_report_t, field by field
+#define HID_REPORT_DESC                                                      \
+    0x05, 0x01,        /* Usage Page (Generic Desktop) */                    \
+    0x09, 0x05,        /* Usage (Gamepad) */                                 \
+    0xA1, 0x01,        /* Collection (Application) */                        \
+    0x09, 0x30,        /*   Usage (X) */                                     \
+    0x09, 0x31,        /*   Usage (Y) */                                     \
+    0x09, 0x32,        /*   Usage (Z) */                                     \
+    0x09, 0x35,        /*   Usage (Rz) */                                    \
+    0x09, 0x33,        /*   Usage (Rx) */                                    \
+    0x09, 0x34,        /*   Usage (Ry) */                                    \
+    0x15, 0x81,        /*   Logical Minimum (-127) */                        \
+    0x25, 0x7F,        /*   Logical Maximum (127) */                         \
+    0x95, 0x06,        /*   Report Count (6) */                              \
+    0x75, 0x08,        /*   Report Size (8) */                               \
+    0x81, 0x02,        /*   Input (Data, Var, Abs) */                        \
+    0x09, 0x39,        /*   Usage (Hat Switch) */                            \
+    0x15, 0x01,        /*   Logical Minimum (1) */                           \
+    0x25, 0x08,        /*   Logical Maximum (8) */                           \
+    0x35, 0x00,        /*   Physical Minimum (0) */                          \
+    0x46, 0x3B, 0x01,  /*   Physical Maximum (315) */                        \
+    0x95, 0x01,        /*   Report Count (1) */                              \
+    0x75, 0x08,        /*   Report Size (8) */                               \
+    0x81, 0x42,        /*   Input (Data, Var, Abs, Null State) */            \
+    0x05, 0x09,        /*   Usage Page (Button) */                           \
+    0x19, 0x01,        /*   Usage Minimum (1) */                             \
+    0x29, 0x20,        /*   Usage Maximum (32) */                            \
+    0x15, 0x00,        /*   Logical Minimum (0) */                           \
+    0x25, 0x01,        /*   Logical Maximum (1) */                           \
+    0x95, 0x20,        /*   Report Count (32) */                             \
+    0x75, 0x01,        /*   Report Size (1) */                               \
+    0x81, 0x02,        /*   Input (Data, Var, Abs) */                        \
+    0xC0               /* End Collection */
+
+// Edge code n is button n; the FSR level also drives Z and the pot
+// (0-255) drives Rx
+void hid_pack_report(const input_state_t *st, hid_report_t *report);
+
+#endif
@@ -1,18 +1,15 @@
 #include "pico/stdlib.h"
 #include "FreeRTOS.h"
 #include "task.h"
-#include "queue.h"
-#include "semphr.h"
 
 #include "common.h"
 #include "pot.h"
 #include "button.h"
 #include "fsr.h"
 #include "hc06_task.h"
-
-QueueHandle_t xQueueADC;
-QueueHandle_t xQueueBTN;
-SemaphoreHandle_t xFSRSem;
+#include "command.h"
+#include "usb_hid.h"
+#include "transport.h"
 
 button_config_t buttons[NUM_BUTTONS] = {
     {9, 0x01}, {6, 0x02}, {7, 0x03}, {8, 0x04},
@@ -20,13 +17,38 @@ button_config_t buttons[NUM_BUTTONS] = {
     {21, 0x0C}, {20, 0x0D}, {19, 0x0E}, {18, 0x0F}
 };
 
+// configSUPPORT_STATIC_ALLOCATION needs the kernel's own tasks to be given memory
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer,
+                                   StackType_t **ppxIdleTaskStackBuffer,
+                                   uint32_t *pulIdleTaskStackSize) {
+    static StaticTask_t idle_tcb;
+    static StackType_t idle_stack[configMINIMAL_STACK_SIZE];
+
+    *ppxIdleTaskTCBBuffer = &idle_tcb;
+    *ppxIdleTaskStackBuffer = idle_stack;
+    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer,
+                                    StackType_t **ppxTimerTaskStackBuffer,
+                                    uint32_t *pulTimerTaskStackSize) {
+    static StaticTask_t timer_tcb;
+    static StackType_t timer_stack[configTIMER_TASK_STACK_DEPTH];
+
+    *ppxTimerTaskTCBBuffer = &timer_tcb;
+    *ppxTimerTaskStackBuffer = timer_stack;
+    *pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+
 int main() {
     stdio_init_all();
     adc_init();
 
-    xQueueADC = xQueueCreate(10, sizeof(adc_data_t));
-    xQueueBTN = xQueueCreate(10, sizeof(uint8_t));
-    xFSRSem = xSemaphoreCreateBinary();
+    hc06_task_init();
+    usb_hid_init();
+    // Every frame goes out on both links; the host listens on either one
+    transport_register(&transport_hc06);
+    transport_register(&transport_cdc);
 
     xTaskCreate(pot_task, "POT", 1024, NULL, 1, NULL);
 
@@ -36,6 +58,9 @@ int main() {
 
     xTaskCreate(fsr_task, "FSR_Read", 1024, NULL, 1, NULL);
     xTaskCreate(hc06C_task, "UART", 1024, NULL, 1, NULL);
+    xTaskCreate(command_task, "CMD", 512, NULL, 1, NULL);
+    // Above the scanners so a report goes out as soon as an edge is posted
+    xTaskCreate(usb_hid_task, "USB", 1024, NULL, 2, NULL);
     vTaskStartScheduler();
 
     while (1);
@@ -1,11 +1,10 @@
 #include "pot.h"
 #include "common.h"
+#include "event_bus.h"
+#include "settings.h"
 #include "hardware/adc.h"
 #include "FreeRTOS.h"
 #include "task.h"
-#include "queue.h"
-
-extern QueueHandle_t xQueueADC;
 
 static int16_t process_pot_value(uint16_t raw) {
     return raw * 255 / 4095;
@@ -33,12 +32,11 @@ void pot_task(void *p) {
         uint16_t avg = sum / WINDOW_SIZE;
         int16_t converted = process_pot_value(avg);
 
-        if (abs(converted - last_sent) > 2) {
-            adc_data_t data = { .axis = AXIS_POT, .value = converted };
-            xQueueSend(xQueueADC, &data, portMAX_DELAY);
+        if (abs(converted - last_sent) > settings.pot_deadband) {
+            bus_post_event(EV_SRC_POT, AXIS_POT, converted);
             last_sent = converted;
         }
 
-        vTaskDelay(pdMS_TO_TICKS(50));
+        vTaskDelay(pdMS_TO_TICKS(settings.pot_period_ms));
     }
 }
@@ -0,0 +1,230 @@
+// Gerado por protocol/gerar.py a partir de protocol/schema.json. Não edite.
+#ifndef PROTO_FRAMES_H
+#define PROTO_FRAMES_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define PROTO_VERSION 1
+
+// Device -> host control codes, after [seq]. Input codes are 0x00-0x0F (press/analog) and 0x80-0x8F (release).
+#define PROTO_CODE_PONG      0x70
+#define PROTO_CODE_STATS     0x71
+#define PROTO_CODE_CMD_OK    0x72
+#define PROTO_CODE_HEARTBEAT 0x73
+#define PROTO_CODE_STATE     0x74
+#define PROTO_CODE_HELLO     0x75
+#define PROTO_CODE_LINKS     0x76
+#define PROTO_CODE_TIME      0x77
+#define PROTO_CODE_PROBE     0x78
+
+// Host -> device commands: [cmd, args...]
+#define PROTO_CMD_PING       0x01
+#define PROTO_CMD_SET_SCAN   0x02
+#define PROTO_CMD_SET_THRESH 0x03
+#define PROTO_CMD_REMAP      0x04
+#define PROTO_CMD_GET_STATS  0x05
+#define PROTO_CMD_RESYNC     0x06
+#define PROTO_CMD_ACK        0x07
+#define PROTO_CMD_SET_FORMAT 0x08
+#define PROTO_CMD_HELLO      0x09
+#define PROTO_CMD_GET_LINKS  0x0A
+#define PROTO_CMD_KEEPALIVE  0x0B
+#define PROTO_CMD_TIME       0x0C
+#define PROTO_CMD_SET_REPORT 0x0D
+#define PROTO_CMD_ECHO       0x0E
+
+// Transport ids in the LINKS reply
+#define PROTO_LINK_HC06 0
+#define PROTO_LINK_CDC  1
+
+// Wire format options the host can turn on; 0 is the original format
+#define PROTO_FMT_COMPACT_ANALOG 0x01
+#define PROTO_FMT_EDGE_TIME      0x02
+#define PROTO_FMT_FEC            0x04
+
+// Compact analog records: DELTA | channel + zig-zag varint, KEY | channel + absolute value, RUN | channel + count + count varints
+#define PROTO_REC_DELTA 0xC0
+#define PROTO_REC_KEY   0xD0
+#define PROTO_REC_RUN   0xE0
+
+// SET_SCAN targets
+#define PROTO_SCAN_BUTTON    0
+#define PROTO_SCAN_POT       1
+#define PROTO_SCAN_FSR       2
+#define PROTO_SCAN_HEARTBEAT 3
+
+// SET_THRESH ids
+#define PROTO_THRESH_FSR_PRESS      0
+#define PROTO_THRESH_FSR_LVL2       1
+#define PROTO_THRESH_FSR_LVL3       2
+#define PROTO_THRESH_POT_DEADBAND   3
+#define PROTO_THRESH_BATCH_LIMIT_MS 4
+#define PROTO_THRESH_ANALOG_HOLD_MS 5
+
+// CMD_OK status
+#define PROTO_STATUS_OK  0
+#define PROTO_STATUS_ERR 1
+
+// Payload writers, big endian; return the payload length
+// Button/FSR edge or analog value
+#define PROTO_FRAME_EVENT_LEN 4
+static inline size_t proto_pack_event(uint8_t *out, uint8_t seq, uint8_t code, int16_t value) {
+    out[0] = seq;
+    out[1] = code;
+    out[2] = ((uint16_t)value >> 8) & 0xFF;
+    out[3] = (uint16_t)value & 0xFF;
+    return 4;
+}
+
+// Edge with FMT_EDGE_TIME: when it was posted (time_us_32) and how long it waited before going out
+#define PROTO_FRAME_EVENT_TIMED_LEN 10
+static inline size_t proto_pack_event_timed(uint8_t *out, uint8_t seq, uint8_t code, int16_t value, uint32_t at_us, uint16_t queue_us) {
+    out[0] = seq;
+    out[1] = code;
+    out[2] = ((uint16_t)value >> 8) & 0xFF;
+    out[3] = (uint16_t)value & 0xFF;
+    out[4] = ((uint32_t)at_us >> 24) & 0xFF;
+    out[5] = ((uint32_t)at_us >> 16) & 0xFF;
+    out[6] = ((uint32_t)at_us >> 8) & 0xFF;
+    out[7] = (uint32_t)at_us & 0xFF;
+    out[8] = ((uint16_t)queue_us >> 8) & 0xFF;
+    out[9] = (uint16_t)queue_us & 0xFF;
+    return 10;
+}
+
+#define PROTO_FRAME_HEARTBEAT_LEN 2
+static inline size_t proto_pack_heartbeat(uint8_t *out, uint8_t seq) {
+    out[0] = seq;
+    out[1] = PROTO_CODE_HEARTBEAT;
+    return 2;
+}
+
+// Full input state, bit n of pressed is edge code n
+#define PROTO_FRAME_STATE_LEN 7
+static inline size_t proto_pack_state(uint8_t *out, uint8_t seq, uint16_t pressed, uint8_t fsr, int16_t pot) {
+    out[0] = seq;
+    out[1] = PROTO_CODE_STATE;
+    out[2] = ((uint16_t)pressed >> 8) & 0xFF;
+    out[3] = (uint16_t)pressed & 0xFF;
+    out[4] = fsr;
+    out[5] = ((uint16_t)pot >> 8) & 0xFF;
+    out[6] = (uint16_t)pot & 0xFF;
+    return 7;
+}
+
+#define PROTO_FRAME_PONG_LEN 4
+static inline size_t proto_pack_pong(uint8_t *out, uint8_t seq, uint16_t token) {
+    out[0] = seq;
+    out[1] = PROTO_CODE_PONG;
+    out[2] = ((uint16_t)token >> 8) & 0xFF;
+    out[3] = (uint16_t)token & 0xFF;
+    return 4;
+}
+
+#define PROTO_FRAME_CMD_OK_LEN 4
+static inline size_t proto_pack_cmd_ok(uint8_t *out, uint8_t seq, uint8_t cmd, uint8_t status) {
+    out[0] = seq;
+    out[1] = PROTO_CODE_CMD_OK;
+    out[2] = cmd;
+    out[3] = status;
+    return 4;
+}
+
+// Capabilities; followed by button_count button codes
+#define PROTO_FRAME_HELLO_LEN 10
+static inline size_t proto_pack_hello(uint8_t *out, uint8_t seq, uint8_t version, uint8_t formats, uint8_t channels, uint8_t tick_ms, uint8_t heartbeat_10ms, uint8_t fsr_first, uint8_t fsr_levels, uint8_t button_count) {
+    out[0] = seq;
+    out[1] = PROTO_CODE_HELLO;
+    out[2] = version;
+    out[3] = formats;
+    out[4] = channels;
+    out[5] = tick_ms;
+    out[6] = heartbeat_10ms;
+    out[7] = fsr_first;
+    out[8] = fsr_levels;
+    out[9] = button_count;
+    return 10;
+}
+
+// Clock sync reply: device time_us_32 when the request was read and when the reply went out
+#define PROTO_FRAME_TIME_LEN 12
+static inline size_t proto_pack_time(uint8_t *out, uint8_t seq, uint16_t token, uint32_t rx_us, uint32_t tx_us) {
+    out[0] = seq;
+    out[1] = PROTO_CODE_TIME;
+    out[2] = ((uint16_t)token >> 8) & 0xFF;
+    out[3] = (uint16_t)token & 0xFF;
+    out[4] = ((uint32_t)rx_us >> 24) & 0xFF;
+    out[5] = ((uint32_t)rx_us >> 16) & 0xFF;
+    out[6] = ((uint32_t)rx_us >> 8) & 0xFF;
+    out[7] = (uint32_t)rx_us & 0xFF;
+    out[8] = ((uint32_t)tx_us >> 24) & 0xFF;
+    out[9] = ((uint32_t)tx_us >> 16) & 0xFF;
+    out[10] = ((uint32_t)tx_us >> 8) & 0xFF;
+    out[11] = (uint32_t)tx_us & 0xFF;
+    return 12;
+}
+
+// Latency probe, the host echoes at_us back with PROTO_CMD_ECHO
+#define PROTO_FRAME_PROBE_LEN 6
+static inline size_t proto_pack_probe(uint8_t *out, uint8_t seq, uint32_t at_us) {
+    out[0] = seq;
+    out[1] = PROTO_CODE_PROBE;
+    out[2] = ((uint32_t)at_us >> 24) & 0xFF;
+    out[3] = ((uint32_t)at_us >> 16) & 0xFF;
+    out[4] = ((uint32_t)at_us >> 8) & 0xFF;
+    out[5] = (uint32_t)at_us & 0xFF;
+    return 6;
+}
+
+// One transport in the LINKS reply, after [code, count]
+#define PROTO_FRAME_LINK_LEN 8
+static inline size_t proto_pack_link(uint8_t *out, uint8_t ident, uint8_t ready, uint16_t pending, uint16_t drops, uint16_t latency_us) {
+    out[0] = ident;
+    out[1] = ready;
+    out[2] = ((uint16_t)pending >> 8) & 0xFF;
+    out[3] = (uint16_t)pending & 0xFF;
+    out[4] = ((uint16_t)drops >> 8) & 0xFF;
+    out[5] = (uint16_t)drops & 0xFF;
+    out[6] = ((uint16_t)latency_us >> 8) & 0xFF;
+    out[7] = (uint16_t)latency_us & 0xFF;
+    return 8;
+}
+
+// Command lengths, including the command byte
+#define PROTO_CMD_PING_LEN 3
+#define PROTO_CMD_SET_SCAN_LEN 4
+#define PROTO_CMD_SET_THRESH_LEN 4
+#define PROTO_CMD_REMAP_LEN 3
+#define PROTO_CMD_GET_STATS_LEN 1
+#define PROTO_CMD_RESYNC_LEN 1
+#define PROTO_CMD_ACK_LEN 3
+#define PROTO_CMD_SET_FORMAT_LEN 2
+#define PROTO_CMD_HELLO_LEN 1
+#define PROTO_CMD_GET_LINKS_LEN 1
+#define PROTO_CMD_KEEPALIVE_LEN 1
+#define PROTO_CMD_TIME_LEN 3
+#define PROTO_CMD_SET_REPORT_LEN 2
+#define PROTO_CMD_ECHO_LEN 7
+
+// Field order of the PROTO_CODE_STATS reply, 16 bits each
+enum {
+    PROTO_STAT_BTN_DROPS,
+    PROTO_STAT_FSR_DROPS,
+    PROTO_STAT_POT_COALESCED,
+    PROTO_STAT_TX_OVERFLOWS,
+    PROTO_STAT_TX_PEAK,
+    PROTO_STAT_RX_OVERFLOWS,
+    PROTO_STAT_BAD_CMD_FRAMES,
+    PROTO_STAT_BAUD_X100,
+    PROTO_STAT_RETRANSMITS,
+    PROTO_STAT_EDGE_QUEUE_US,
+    PROTO_STAT_EDGE_LINE_US,
+    PROTO_STAT_REPORT_PERIOD_10US,
+    PROTO_STAT_REPORT_JITTER_10US,
+    PROTO_STAT_BATCH_WINDOW_US,
+    PROTO_STAT_PROBE_RTT_X100US,
+    PROTO_STAT_COUNT
+};
+
+#endif
@@ -0,0 +1,130 @@
+#include "protocol.h"
+
+// CRC-8, polynomial 0x07, init 0xFF (same as python/protocol.py). With
+// init 0x00 a frame that lost its leading zero bytes (seq 0) still checks.
+uint8_t proto_crc8(const uint8_t *data, size_t len) {
+    uint8_t crc = 0xFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) {
+            if (crc & 0x80)
+                crc = (crc << 1) ^ 0x07;
+            else
+                crc <<= 1;
+        }
+    }
+    return crc;
+}
+
+size_t proto_cobs_encode(const uint8_t *src, size_t len, uint8_t *dst) {
+    size_t code_idx = 0;
+    size_t out = 1;
+    uint8_t code = 1;
+
+    for (size_t i = 0; i < len; i++) {
+        if (src[i] == 0) {
+            dst[code_idx] = code;
+            code_idx = out++;
+            code = 1;
+        } else {
+            dst[out++] = src[i];
+            if (++code == 0xFF) {
+                dst[code_idx] = code;
+                code_idx = out++;
+                code = 1;
+            }
+        }
+    }
+    dst[code_idx] = code;
+    return out;
+}
+
+// Returns 0 if the block structure is broken
+size_t proto_cobs_decode(const uint8_t *src, size_t len, uint8_t *dst) {
+    size_t in = 0;
+    size_t out = 0;
+
+    while (in < len) {
+        uint8_t code = src[in++];
+        if (code == 0 || in + code - 1 > len)
+            return 0;
+        for (uint8_t i = 1; i < code; i++)
+            dst[out++] = src[in++];
+        if (code != 0xFF && in < len)
+            dst[out++] = 0;
+    }
+    return out;
+}
+
+// payload + crc8, COBS encoded, plus the delimiter. out must hold
+// PROTO_MAX_FRAME bytes; returns the number of bytes to send.
+size_t proto_encode_frame(const uint8_t *payload, size_t len, uint8_t *out) {
+    uint8_t raw[PROTO_MAX_PAYLOAD + 1];
+
+    if (len > PROTO_MAX_PAYLOAD)
+        return 0;
+
+    for (size_t i = 0; i < len; i++)
+        raw[i] = payload[i];
+    raw[len] = proto_crc8(payload, len);
+
+    size_t n = proto_cobs_encode(raw, len + 1, out);
+    out[n++] = PROTO_DELIMITER;
+    return n;
+}
+
+// Multiply by x in GF(256), polynomial 0x11D
+static uint8_t gf_xtime(uint8_t v) {
+    return (v << 1) ^ ((v & 0x80) ? 0x1D : 0x00);
+}
+
+// Same as proto_encode_frame, with P = sum of B[i] and Q = sum of
+// x^i * B[i] over the COBS block B. Q comes from Horner's rule, so no
+// tables are needed here; only the host has to find the error position.
+// out must hold PROTO_MAX_FRAME_FEC bytes.
+size_t proto_encode_frame_fec(const uint8_t *payload, size_t len, uint8_t *out) {
+    size_t n = proto_encode_frame(payload, len, out);
+    if (n == 0)
+        return 0;
+
+    n--;  // drop the delimiter, parity goes first
+    uint8_t parity[2] = {0, 0};
+    for (size_t i = n; i-- > 0;) {
+        parity[0] ^= out[i];
+        parity[1] = gf_xtime(parity[1]) ^ out[i];
+    }
+
+    n += proto_cobs_encode(parity, 2, &out[n]);
+    out[n++] = PROTO_DELIMITER;
+    return n;
+}
+
+// frame is the COBS block without the delimiter, at most PROTO_MAX_FRAME
+// bytes. Returns the payload length, or 0 if the frame is corrupt.
+size_t proto_decode_frame(const uint8_t *frame, size_t len, uint8_t *payload) {
+    uint8_t raw[PROTO_MAX_FRAME];
+
+    if (len == 0 || len > PROTO_MAX_FRAME)
+        return 0;
+
+    size_t n = proto_cobs_decode(frame, len, raw);
+    if (n < 2 || n - 1 > PROTO_MAX_PAYLOAD || proto_crc8(raw, n - 1) != raw[n - 1])
+        return 0;
+
+    for (size_t i = 0; i < n - 1; i++)
+        payload[i] = raw[i];
+    return n - 1;
+}
+
+// 7 bits per byte, least significant group first, bit 7 set on all but
+// the last byte
+size_t proto_put_varint(uint8_t *out, uint16_t value) {
+    size_t n = 0;
+
+    while (value >= 0x80) {
+        out[n++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    out[n++] = value;
+    return n;
+}
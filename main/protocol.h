@@ -0,0 +1,39 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+// Codes, commands and payload layouts, generated from protocol/schema.json
+#include "proto_frames.h"
+
+// Frames are COBS encoded and terminated by PROTO_DELIMITER, so the
+// receiver can always resync on the next 0x00 no matter what the payload
+// bytes are. The last byte of the decoded payload is a CRC-8 of the rest.
+#define PROTO_DELIMITER   0x00
+#define PROTO_MAX_PAYLOAD 32
+#define PROTO_MAX_FRAME   (PROTO_MAX_PAYLOAD + 3)
+
+// With PROTO_FMT_FEC two Reed-Solomon parity bytes over GF(256) follow the
+// COBS block, COBS encoded on their own (always 3 bytes). The host can
+// fix any single corrupted byte that is not, or does not turn into, 0x00.
+#define PROTO_FEC_LEN       3
+#define PROTO_MAX_FRAME_FEC (PROTO_MAX_FRAME + PROTO_FEC_LEN)
+
+// Device -> host payload: [seq, code, data...]; host -> device: [cmd, args...]
+#define PROTO_FMT_SUPPORTED (PROTO_FMT_COMPACT_ANALOG | PROTO_FMT_EDGE_TIME | PROTO_FMT_FEC)
+#define PROTO_REC_MAX       4  // header + 3 varint bytes
+
+uint8_t proto_crc8(const uint8_t *data, size_t len);
+size_t proto_cobs_encode(const uint8_t *src, size_t len, uint8_t *dst);
+size_t proto_cobs_decode(const uint8_t *src, size_t len, uint8_t *dst);
+size_t proto_encode_frame(const uint8_t *payload, size_t len, uint8_t *out);
+size_t proto_encode_frame_fec(const uint8_t *payload, size_t len, uint8_t *out);
+size_t proto_decode_frame(const uint8_t *frame, size_t len, uint8_t *payload);
+size_t proto_put_varint(uint8_t *out, uint16_t value);
+
+static inline uint16_t proto_zigzag(int16_t v) {
+    // Shift the unsigned bits: left-shifting a negative int is undefined
+    return (uint16_t)(((uint16_t)v << 1) ^ (v >> 15));
+}
+
+#endif
@@ -0,0 +1,16 @@
+#include "settings.h"
+
+settings_t settings = {
+    .button_period_ms = 20,
+    .pot_period_ms = 50,
+    .fsr_period_ms = 40,
+    .heartbeat_ms = 250,
+    .fsr_press_raw = 300,
+    .fsr_lvl2 = 0x1B,
+    .fsr_lvl3 = 0x2C,
+    .pot_deadband = 2,
+    .batch_limit_ms = 0,
+    .analog_hold_ms = 400,
+    .wire_format = 0,
+    .report_ms = 0,
+};
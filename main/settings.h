@@ -0,0 +1,25 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <stdint.h>
+
+// Runtime tunables. Tasks read them on every loop, so a host command
+// takes effect on the next scan without a reboot.
+typedef struct {
+    uint16_t button_period_ms;
+    uint16_t pot_period_ms;
+    uint16_t fsr_period_ms;
+    uint16_t heartbeat_ms;   // idle time after which the transport sends a heartbeat
+    uint16_t fsr_press_raw;  // raw ADC reading below which the FSR is released
+    uint8_t fsr_lvl2;        // converted level where FSR_LVL2 starts
+    uint8_t fsr_lvl3;        // converted level where FSR_LVL3 starts
+    uint8_t pot_deadband;    // minimum change before a pot update is sent
+    uint8_t batch_limit_ms;  // longest the first event of a batch may wait, 0 disables batching
+    uint16_t analog_hold_ms; // compact analog: longest an update waits for others to share its frame
+    uint8_t wire_format;     // PROTO_FMT_* flags chosen by the host
+    uint8_t report_ms;       // fixed report interval, 0 sends events as they happen
+} settings_t;
+
+extern settings_t settings;
+
+#endif
@@ -0,0 +1,168 @@
+#include "transport.h"
+#include "pico/stdlib.h"
+
+static transport_t *transports[TRANSPORT_MAX];
+static size_t count = 0;
+static TaskHandle_t rx_task = NULL;
+static bool was_ready[TRANSPORT_MAX];
+static bool reconnected = false;
+
+// A ready link whose queue has not moved for this long is skipped until
+// it drains again, so a CDC port that is open but not being read cannot
+// hold the HC-06 back through the shared pace
+#ifndef TRANSPORT_STALL_US
+#define TRANSPORT_STALL_US 500000
+#endif
+
+static size_t last_pending[TRANSPORT_MAX];
+static uint32_t last_bytes[TRANSPORT_MAX];
+static uint32_t last_progress[TRANSPORT_MAX];
+static bool stalled[TRANSPORT_MAX];
+
+void transport_register(transport_t *t) {
+    if (count < TRANSPORT_MAX)
+        transports[count++] = t;
+}
+
+size_t transport_count(void) {
+    return count;
+}
+
+transport_t *transport_get(size_t i) {
+    return i < count ? transports[i] : NULL;
+}
+
+void transport_start_all(void) {
+    for (size_t i = 0; i < count; i++)
+        transports[i]->start();
+}
+
+// Ready and not stalled
+static bool link_live(size_t i) {
+    return transports[i]->ready() && !stalled[i];
+}
+
+// Progress is any byte that left the queue since the last check, counting
+// what was written in between
+static void check_stall(size_t i, uint32_t now) {
+    transport_t *t = transports[i];
+    size_t pending = t->pending(TRANSPORT_LANE_EDGE) + t->pending(TRANSPORT_LANE_BULK);
+    size_t queued = last_pending[i] + (t->stats.bytes - last_bytes[i]);
+
+    if (pending == 0 || pending < queued || !t->ready())
+        last_progress[i] = now;
+    last_pending[i] = pending;
+    last_bytes[i] = t->stats.bytes;
+    stalled[i] = now - last_progress[i] >= TRANSPORT_STALL_US;
+}
+
+TickType_t transport_poll_all(void) {
+    TickType_t wait = portMAX_DELAY;
+
+    for (size_t i = 0; i < count; i++) {
+        if (transports[i]->poll == NULL)
+            continue;
+        TickType_t w = transports[i]->poll();
+        if (w < wait)
+            wait = w;
+    }
+
+    uint32_t now = time_us_32();
+    for (size_t i = 0; i < count; i++) {
+        check_stall(i, now);
+        bool ready = link_live(i);
+        if (ready && !was_ready[i])
+            reconnected = true;
+        was_ready[i] = ready;
+    }
+    return wait;
+}
+
+bool transport_any_ready(void) {
+    for (size_t i = 0; i < count; i++) {
+        if (link_live(i))
+            return true;
+    }
+    return false;
+}
+
+bool transport_reconnected(void) {
+    bool r = reconnected;
+    reconnected = false;
+    return r;
+}
+
+// The slowest ready link sets the pace, so every ready link gets every
+// batch. Pacing by the fastest one made the slower link drop whole
+// batches, edges included, that the shared retransmit window had
+// already counted as sent. A stalled link does not count.
+size_t transport_room(transport_lane_t lane) {
+    size_t room = SIZE_MAX;
+
+    for (size_t i = 0; i < count; i++) {
+        if (!link_live(i))
+            continue;
+        size_t r = transports[i]->room(lane);
+        if (r < room)
+            room = r;
+    }
+    return room == SIZE_MAX ? 0 : room;
+}
+
+size_t transport_pending(transport_lane_t lane) {
+    size_t pending = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (!link_live(i))
+            continue;
+        size_t p = transports[i]->pending(lane);
+        if (p > pending)
+            pending = p;
+    }
+    return pending;
+}
+
+// Returns true if at least one link took the batch. oldest_us is the
+// timestamp of the oldest event in it, or 0 if there is none.
+bool transport_send(transport_lane_t lane, const uint8_t *data, size_t len, uint32_t oldest_us) {
+    uint32_t now = time_us_32();
+    bool sent = false;
+
+    for (size_t i = 0; i < count; i++) {
+        transport_t *t = transports[i];
+        if (!link_live(i))
+            continue;
+        if (!t->write(lane, data, len)) {
+            t->stats.drops++;
+            continue;
+        }
+        sent = true;
+        t->stats.frames++;
+        t->stats.bytes += len;
+        if (oldest_us != 0 && now - oldest_us > t->stats.latency_max_us)
+            t->stats.latency_max_us = now - oldest_us;
+    }
+    return sent;
+}
+
+// Nothing queued on any ready link
+bool transport_idle(void) {
+    return transport_pending(TRANSPORT_LANE_EDGE) == 0 && transport_pending(TRANSPORT_LANE_BULK) == 0;
+}
+
+void transport_set_rx_notify(TaskHandle_t task) {
+    rx_task = task;
+}
+
+void transport_rx_notify_from_isr(void) {
+    if (rx_task == NULL)
+        return;
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(rx_task, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+void transport_rx_notify(void) {
+    if (rx_task != NULL)
+        xTaskNotifyGive(rx_task);
+}
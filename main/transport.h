@@ -0,0 +1,70 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+// A link to the host. hc06_task encodes each batch once and fans it out
+// to every transport that is ready; command_task reads commands from all
+// of them.
+typedef enum {
+    TRANSPORT_LANE_EDGE,  // served first where the backend supports it
+    TRANSPORT_LANE_BULK,
+} transport_lane_t;
+
+typedef struct {
+    uint32_t frames;          // batches accepted
+    uint32_t bytes;
+    uint32_t drops;           // batches rejected because the backend was full
+    uint32_t latency_max_us;  // oldest event of a batch -> handed to the backend
+} transport_stats_t;
+
+typedef struct {
+    uint8_t id;  // PROTO_LINK_*
+    void (*start)(void);
+    // Housekeeping (e.g. AT provisioning); returns the ticks until it
+    // needs to run again
+    TickType_t (*poll)(void);
+    bool (*ready)(void);  // link up and able to take frames
+    size_t (*room)(transport_lane_t lane);
+    bool (*write)(transport_lane_t lane, const uint8_t *data, size_t len);  // all or nothing
+    size_t (*pending)(transport_lane_t lane);  // bytes queued but not on the wire yet
+    size_t (*read)(uint8_t *data, size_t len);  // never blocks
+    void (*keepalive)(void);  // host keepalive arrived on this link, may be NULL
+    transport_stats_t stats;
+} transport_t;
+
+#ifndef TRANSPORT_MAX
+#define TRANSPORT_MAX 2
+#endif
+
+extern transport_t transport_hc06;
+extern transport_t transport_cdc;
+
+// Moves bytes between transport_cdc and TinyUSB; only usb_hid_task calls it
+void transport_cdc_service(void);
+
+void transport_register(transport_t *t);
+size_t transport_count(void);
+transport_t *transport_get(size_t i);
+
+// Fan-out helpers for the encoder task
+void transport_start_all(void);
+TickType_t transport_poll_all(void);
+size_t transport_room(transport_lane_t lane);
+size_t transport_pending(transport_lane_t lane);
+bool transport_send(transport_lane_t lane, const uint8_t *data, size_t len, uint32_t oldest_us);
+bool transport_idle(void);
+bool transport_any_ready(void);
+// True once after any link came up since the last call
+bool transport_reconnected(void);
+
+// Wakes task whenever any transport receives bytes
+void transport_set_rx_notify(TaskHandle_t task);
+void transport_rx_notify_from_isr(void);
+void transport_rx_notify(void);
+
+#endif
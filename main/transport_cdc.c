@@ -0,0 +1,121 @@
+#include "transport.h"
+#include "protocol.h"
+#include "usb_hid.h"
+#include "stream_buffer.h"
+#include "tusb.h"
+
+// USB CDC serial, same frames as the HC-06 link. A wired fallback that
+// needs no pairing. usb_hid_task runs the USB stack and is the only task
+// that calls into TinyUSB: the encoder and command tasks go through two
+// stream buffers (one writer, one reader each) that
+// transport_cdc_service() moves to and from the CDC FIFOs. The CDC FIFO
+// has a single lane, and USB drains it every frame, so edges never wait
+// long.
+
+#define CDC_TX_BUFFER_SIZE 256
+#define CDC_RX_BUFFER_SIZE 128
+
+static StreamBufferHandle_t tx_stream;
+static StaticStreamBuffer_t tx_stream_struct;
+static uint8_t tx_storage[CDC_TX_BUFFER_SIZE + 1];
+static StreamBufferHandle_t rx_stream;
+static StaticStreamBuffer_t rx_stream_struct;
+static uint8_t rx_storage[CDC_RX_BUFFER_SIZE + 1];
+
+// Snapshots taken by the USB task
+static volatile bool connected = false;
+static volatile size_t fifo_used = 0;
+
+static void cdc_transport_start(void) {
+    rx_stream = xStreamBufferCreateStatic(CDC_RX_BUFFER_SIZE, 1, rx_storage, &rx_stream_struct);
+    tx_stream = xStreamBufferCreateStatic(CDC_TX_BUFFER_SIZE, 1, tx_storage, &tx_stream_struct);
+}
+
+static bool cdc_transport_ready(void) {
+    return connected;
+}
+
+static size_t cdc_transport_room(transport_lane_t lane) {
+    (void)lane;
+    return xStreamBufferSpacesAvailable(tx_stream);
+}
+
+static bool cdc_transport_write(transport_lane_t lane, const uint8_t *data, size_t len) {
+    (void)lane;
+    if (xStreamBufferSpacesAvailable(tx_stream) < len)
+        return false;
+    xStreamBufferSend(tx_stream, data, len, 0);
+    usb_hid_wake();
+    return true;
+}
+
+static size_t cdc_transport_pending(transport_lane_t lane) {
+    if (lane == TRANSPORT_LANE_EDGE)
+        return 0;
+    return xStreamBufferBytesAvailable(tx_stream) + fifo_used;
+}
+
+// command_task may read before hc06_task has started the transports
+static size_t cdc_transport_read(uint8_t *data, size_t len) {
+    if (rx_stream == NULL)
+        return 0;
+    return xStreamBufferReceive(rx_stream, data, len, 0);
+}
+
+// Runs in usb_hid_task after every tud_task()
+void transport_cdc_service(void) {
+    uint8_t buf[64];
+    size_t n;
+
+    if (tx_stream == NULL)
+        return;
+
+    connected = tud_cdc_connected();
+    if (!connected) {
+        // Nobody is listening: what was queued is stale by the time a
+        // terminal opens the port
+        while (xStreamBufferReceive(tx_stream, buf, sizeof(buf), 0) > 0)
+            ;
+        fifo_used = 0;
+        return;
+    }
+
+    bool wrote = false;
+    while ((n = tud_cdc_write_available()) > 0) {
+        if (n > sizeof(buf))
+            n = sizeof(buf);
+        n = xStreamBufferReceive(tx_stream, buf, n, 0);
+        if (n == 0)
+            break;
+        tud_cdc_write(buf, n);
+        wrote = true;
+    }
+    if (wrote)
+        tud_cdc_write_flush();
+    fifo_used = CFG_TUD_CDC_TX_BUFSIZE - tud_cdc_write_available();
+
+    bool received = false;
+    while (tud_cdc_available() && (n = xStreamBufferSpacesAvailable(rx_stream)) > 0) {
+        if (n > sizeof(buf))
+            n = sizeof(buf);
+        n = tud_cdc_read(buf, n);
+        if (n == 0)
+            break;
+        xStreamBufferSend(rx_stream, buf, n, 0);
+        received = true;
+    }
+    if (received)
+        transport_rx_notify();
+}
+
+transport_t transport_cdc = {
+    .id = PROTO_LINK_CDC,
+    .start = cdc_transport_start,
+    .poll = NULL,
+    .ready = cdc_transport_ready,
+    .room = cdc_transport_room,
+    .write = cdc_transport_write,
+    .pending = cdc_transport_pending,
+    .read = cdc_transport_read,
+    .keepalive = NULL,
+};
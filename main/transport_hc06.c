@@ -0,0 +1,105 @@
+#include "transport.h"
+#include "hc06.h"
+#include "protocol.h"
+#include "uart_tx.h"
+#include "uart_rx.h"
+#include "hardware/uart.h"
+#include "hardware/gpio.h"
+
+// UART1 into the HC-06. Streaming starts right away; AT provisioning, if
+// still needed, runs from poll() and holds the link while it owns the line.
+
+// Some modules blink STATE while unpaired, so it has to stay high this
+// long before the link counts as up
+#define STATE_STABLE_MS 500
+// Once the host has sent a keepalive, this much silence means it is gone
+#define HOST_SILENCE_MS 2000
+// How often poll() samples the link while streaming
+#define LINK_POLL_MS 100
+
+static bool link_up = true;
+static TickType_t state_high_since = 0;
+static volatile bool host_heard = false;
+static volatile TickType_t host_last = 0;
+
+static bool state_pin_up(TickType_t now) {
+#if HC06_STATE_PIN >= 0
+    if (!gpio_get(HC06_STATE_PIN)) {
+        state_high_since = now;
+        return false;
+    }
+    return now - state_high_since >= pdMS_TO_TICKS(STATE_STABLE_MS);
+#else
+    (void)now;
+    return true;
+#endif
+}
+
+// The STATE pin catches a dropped Bluetooth connection; missing
+// keepalives catch a script that stopped reading. Old scripts never send
+// keepalives and only the pin applies to them.
+static TickType_t hc06_transport_poll(void) {
+    TickType_t now = xTaskGetTickCount();
+    TickType_t wait = hc06_poll();
+    bool host_up = !host_heard || now - host_last < pdMS_TO_TICKS(HOST_SILENCE_MS);
+
+    link_up = state_pin_up(now) && host_up;
+    if (wait > pdMS_TO_TICKS(LINK_POLL_MS))
+        wait = pdMS_TO_TICKS(LINK_POLL_MS);
+    return wait;
+}
+
+static void hc06_transport_start(void) {
+#if HC06_STATE_PIN >= 0
+    gpio_init(HC06_STATE_PIN);
+    gpio_set_dir(HC06_STATE_PIN, GPIO_IN);
+    gpio_pull_up(HC06_STATE_PIN);
+#endif
+    uart_init(HC06_UART_ID, hc06_start(HC06_NAME, HC06_PIN));
+    gpio_set_function(HC06_TX_PIN, GPIO_FUNC_UART);
+    gpio_set_function(HC06_RX_PIN, GPIO_FUNC_UART);
+    uart_tx_init(HC06_UART_ID);
+    uart_rx_init(HC06_UART_ID);
+    uart_rx_set_notify(transport_rx_notify_from_isr);
+}
+
+static bool hc06_transport_ready(void) {
+    return link_up && !hc06_at_busy();
+}
+
+static uart_tx_lane_t to_uart_lane(transport_lane_t lane) {
+    return lane == TRANSPORT_LANE_EDGE ? UART_TX_LANE_EDGE : UART_TX_LANE_BULK;
+}
+
+static size_t hc06_transport_room(transport_lane_t lane) {
+    return uart_tx_free_lane(to_uart_lane(lane));
+}
+
+static bool hc06_transport_write(transport_lane_t lane, const uint8_t *data, size_t len) {
+    return uart_tx_write_lane(to_uart_lane(lane), data, len);
+}
+
+static size_t hc06_transport_pending(transport_lane_t lane) {
+    return UART_TX_RING_SIZE - uart_tx_free_lane(to_uart_lane(lane));
+}
+
+static size_t hc06_transport_read(uint8_t *data, size_t len) {
+    return uart_rx_read(data, len, 0);
+}
+
+static void hc06_transport_keepalive(void) {
+    host_last = xTaskGetTickCount();
+    host_heard = true;
+}
+
+transport_t transport_hc06 = {
+    .id = PROTO_LINK_HC06,
+    .start = hc06_transport_start,
+    .poll = hc06_transport_poll,
+    .ready = hc06_transport_ready,
+    .room = hc06_transport_room,
+    .write = hc06_transport_write,
+    .pending = hc06_transport_pending,
+    .read = hc06_transport_read,
+    .keepalive = hc06_transport_keepalive,
+};
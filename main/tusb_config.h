@@ -0,0 +1,21 @@
+#ifndef TUSB_CONFIG_H
+#define TUSB_CONFIG_H
+
+// TinyUSB device config. CFG_TUSB_MCU and CFG_TUSB_OS come from the SDK.
+#define BOARD_TUD_RHPORT       0
+#define CFG_TUSB_RHPORT0_MODE  OPT_MODE_DEVICE
+#define CFG_TUD_ENDPOINT0_SIZE 64
+
+#define CFG_TUD_HID    1
+#define CFG_TUD_CDC    1
+#define CFG_TUD_MSC    0
+#define CFG_TUD_MIDI   0
+#define CFG_TUD_VENDOR 0
+
+#define CFG_TUD_HID_EP_BUFSIZE 16
+
+#define CFG_TUD_CDC_RX_BUFSIZE 64
+#define CFG_TUD_CDC_TX_BUFSIZE 256
+#define CFG_TUD_CDC_EP_BUFSIZE 64
+
+#endif
@@ -0,0 +1,69 @@
+#include "uart_rx.h"
+#include "hardware/irq.h"
+#include "task.h"
+#include "stream_buffer.h"
+
+static uart_inst_t *rx_uart;
+static StreamBufferHandle_t rx_stream;
+static StaticStreamBuffer_t rx_stream_struct;
+static uint8_t rx_storage[UART_RX_BUFFER_SIZE + 1];
+static uint32_t overflows = 0;
+
+// Gets first pick of every byte, e.g. the AT engine while a module
+// command is waiting for its reply
+static uart_rx_hook_t rx_hook = NULL;
+static void (*rx_notify)(void) = NULL;
+
+// Empties the RX FIFO into the stream buffer. Runs on both the FIFO level
+// and the receive timeout interrupts, so short commands are not left
+// sitting in the FIFO.
+static void uart_rx_irq_handler(void) {
+    uart_hw_t *hw = uart_get_hw(rx_uart);
+    BaseType_t woken = pdFALSE;
+
+    if (!(hw->mis & (UART_UARTIMSC_RXIM_BITS | UART_UARTIMSC_RTIM_BITS)))
+        return;
+
+    bool received = false;
+    while (uart_is_readable(rx_uart)) {
+        uint8_t c = (uint8_t)hw->dr;
+        if (rx_hook != NULL && rx_hook(c))
+            continue;
+        if (xStreamBufferSendFromISR(rx_stream, &c, 1, &woken) != 1)
+            overflows++;
+        received = true;
+    }
+    if (received && rx_notify != NULL)
+        rx_notify();
+    portYIELD_FROM_ISR(woken);
+}
+
+void uart_rx_init(uart_inst_t *uart) {
+    rx_uart = uart;
+    rx_stream = xStreamBufferCreateStatic(UART_RX_BUFFER_SIZE, 1, rx_storage, &rx_stream_struct);
+
+    uint irq = uart_get_index(uart) == 0 ? UART0_IRQ : UART1_IRQ;
+    irq_add_shared_handler(irq, uart_rx_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(irq, true);
+    hw_set_bits(&uart_get_hw(uart)->imsc, UART_UARTIMSC_RXIM_BITS | UART_UARTIMSC_RTIM_BITS);
+}
+
+size_t uart_rx_read(uint8_t *data, size_t len, TickType_t wait) {
+    if (rx_stream == NULL) {
+        vTaskDelay(wait);
+        return 0;
+    }
+    return xStreamBufferReceive(rx_stream, data, len, wait);
+}
+
+uint32_t uart_rx_overflows(void) {
+    return overflows;
+}
+
+void uart_rx_set_hook(uart_rx_hook_t hook) {
+    rx_hook = hook;
+}
+
+void uart_rx_set_notify(void (*notify)(void)) {
+    rx_notify = notify;
+}
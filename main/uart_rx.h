@@ -0,0 +1,21 @@
+#ifndef UART_RX_H
+#define UART_RX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "hardware/uart.h"
+#include "FreeRTOS.h"
+
+#define UART_RX_BUFFER_SIZE 128
+
+void uart_rx_init(uart_inst_t *uart);
+size_t uart_rx_read(uint8_t *data, size_t len, TickType_t wait);
+uint32_t uart_rx_overflows(void);
+// Called from the IRQ for each byte; returns true if it consumed it
+typedef bool (*uart_rx_hook_t)(uint8_t c);
+void uart_rx_set_hook(uart_rx_hook_t hook);
+// Called from the IRQ after new bytes went into the stream buffer
+void uart_rx_set_notify(void (*notify)(void));
+
+#endif
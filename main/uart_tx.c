@@ -0,0 +1,154 @@
+#include "uart_tx.h"
+#include "hardware/irq.h"
+#include "pico/time.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+// Single producer (the transport task) writes head, the TX IRQ moves tail.
+// The IRQ keeps the hardware FIFO topped up, so writers never wait for the
+// line: at 9600 baud each byte takes ~1 ms on the wire.
+typedef struct {
+    uint8_t ring[UART_TX_RING_SIZE];
+    volatile uint16_t head;
+    volatile uint16_t tail;
+} tx_lane_t;
+
+static tx_lane_t lanes[UART_TX_LANE_COUNT];
+
+// Lane of the frame being fed to the FIFO; a lane only changes after a
+// delimiter or once its ring runs dry (AT text has no delimiter)
+static uart_tx_lane_t current = UART_TX_LANE_BULK;
+static bool in_frame = false;
+
+static uart_inst_t *tx_uart;
+static volatile uint32_t bytes_sent = 0;
+static uint32_t overflows = 0;
+static uint16_t peak_fill = 0;
+static volatile uint32_t edge_since = 0;
+static volatile uint32_t edge_wait_max = 0;
+
+static inline uint16_t lane_used(const tx_lane_t *l) {
+    return (uint16_t)(l->head - l->tail);
+}
+
+static inline uint16_t ring_used(void) {
+    return lane_used(&lanes[UART_TX_LANE_EDGE]) + lane_used(&lanes[UART_TX_LANE_BULK]);
+}
+
+// Called from the IRQ, or from a writer with interrupts masked. from_irq
+// means the FIFO just dropped to its trigger level, so a bulk frame may
+// start.
+static void uart_tx_fill_fifo(bool from_irq) {
+    uart_hw_t *hw = uart_get_hw(tx_uart);
+    tx_lane_t *edge = &lanes[UART_TX_LANE_EDGE];
+    tx_lane_t *bulk = &lanes[UART_TX_LANE_BULK];
+    bool bulk_ok = from_irq || (hw->fr & UART_UARTFR_TXFE_BITS);
+
+    while (uart_is_writable(tx_uart)) {
+        if (!in_frame || lane_used(&lanes[current]) == 0) {
+            in_frame = false;
+            if (lane_used(edge)) {
+                current = UART_TX_LANE_EDGE;
+                uint32_t waited = time_us_32() - edge_since;
+                if (waited > edge_wait_max)
+                    edge_wait_max = waited;
+            } else if (lane_used(bulk) && bulk_ok) {
+                current = UART_TX_LANE_BULK;
+                bulk_ok = false;  // one bulk frame per FIFO refill
+            } else {
+                break;
+            }
+            in_frame = true;
+        }
+
+        tx_lane_t *l = &lanes[current];
+        uint8_t c = l->ring[l->tail & (UART_TX_RING_SIZE - 1)];
+        hw->dr = c;
+        l->tail++;
+        bytes_sent++;
+        if (c == 0x00) {
+            in_frame = false;
+            // Next edge frame, if any, has been waiting since now
+            if (current == UART_TX_LANE_EDGE)
+                edge_since = time_us_32();
+        }
+    }
+
+    if (ring_used() == 0)
+        hw_clear_bits(&hw->imsc, UART_UARTIMSC_TXIM_BITS);
+    else
+        hw_set_bits(&hw->imsc, UART_UARTIMSC_TXIM_BITS);
+}
+
+static void uart_tx_irq_handler(void) {
+    if (uart_get_hw(tx_uart)->mis & UART_UARTIMSC_TXIM_BITS)
+        uart_tx_fill_fifo(true);
+}
+
+void uart_tx_init(uart_inst_t *uart) {
+    tx_uart = uart;
+    for (int i = 0; i < UART_TX_LANE_COUNT; i++)
+        lanes[i].head = lanes[i].tail = 0;
+
+    // TX interrupt at <= 1/8 full (4 bytes): little bulk data sits in the
+    // FIFO ahead of an edge frame
+    hw_write_masked(&uart_get_hw(uart)->ifls, 0 << UART_UARTIFLS_TXIFLSEL_LSB,
+                    UART_UARTIFLS_TXIFLSEL_BITS);
+
+    uint irq = uart_get_index(uart) == 0 ? UART0_IRQ : UART1_IRQ;
+    irq_add_shared_handler(irq, uart_tx_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(irq, true);
+}
+
+// Rings empty and the last stop bit is out
+bool uart_tx_idle(void) {
+    return ring_used() == 0 && !(uart_get_hw(tx_uart)->fr & UART_UARTFR_BUSY_BITS);
+}
+
+size_t uart_tx_free_lane(uart_tx_lane_t lane) {
+    return UART_TX_RING_SIZE - lane_used(&lanes[lane]);
+}
+
+size_t uart_tx_free(void) {
+    return uart_tx_free_lane(UART_TX_LANE_BULK);
+}
+
+// Non-blocking. The whole buffer is queued or nothing is, so a frame is
+// never cut in half.
+bool uart_tx_write_lane(uart_tx_lane_t lane, const uint8_t *data, size_t len) {
+    tx_lane_t *l = &lanes[lane];
+
+    if (len > uart_tx_free_lane(lane)) {
+        overflows++;
+        return false;
+    }
+
+    uint16_t h = l->head;
+    for (size_t i = 0; i < len; i++)
+        l->ring[(h + i) & (UART_TX_RING_SIZE - 1)] = data[i];
+
+    taskENTER_CRITICAL();
+    if (lane == UART_TX_LANE_EDGE && lane_used(l) == 0)
+        edge_since = time_us_32();
+    l->head = h + len;
+
+    uint16_t used = ring_used();
+    if (used > peak_fill)
+        peak_fill = used;
+
+    uart_tx_fill_fifo(false);
+    taskEXIT_CRITICAL();
+    return true;
+}
+
+bool uart_tx_write(const uint8_t *data, size_t len) {
+    return uart_tx_write_lane(UART_TX_LANE_BULK, data, len);
+}
+
+void uart_tx_get_stats(uart_tx_stats_t *stats) {
+    stats->bytes_sent = bytes_sent;
+    stats->overflows = overflows;
+    stats->fill = ring_used();
+    stats->peak_fill = peak_fill;
+    stats->edge_wait_max_us = edge_wait_max;
+}
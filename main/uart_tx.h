@@ -0,0 +1,38 @@
+#ifndef UART_TX_H
+#define UART_TX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "hardware/uart.h"
+
+// Per lane, must be a power of two
+#define UART_TX_RING_SIZE 256
+
+// The IRQ only switches lanes between frames (after a 0x00 delimiter), and
+// edge frames always win. Bulk frames are started one at a time when the
+// hardware FIFO is nearly empty, so an edge never waits for more than the
+// bulk frame on the wire plus a few FIFO bytes.
+typedef enum {
+    UART_TX_LANE_EDGE,
+    UART_TX_LANE_BULK,
+    UART_TX_LANE_COUNT
+} uart_tx_lane_t;
+
+typedef struct {
+    uint32_t bytes_sent;
+    uint32_t overflows;   // writes rejected because a ring was full
+    uint16_t fill;
+    uint16_t peak_fill;
+    uint32_t edge_wait_max_us;  // edge frame queued -> first byte in the FIFO
+} uart_tx_stats_t;
+
+void uart_tx_init(uart_inst_t *uart);
+bool uart_tx_write_lane(uart_tx_lane_t lane, const uint8_t *data, size_t len);
+size_t uart_tx_free_lane(uart_tx_lane_t lane);
+bool uart_tx_write(const uint8_t *data, size_t len);  // bulk lane
+size_t uart_tx_free(void);                            // bulk lane
+bool uart_tx_idle(void);
+void uart_tx_get_stats(uart_tx_stats_t *stats);
+
+#endif
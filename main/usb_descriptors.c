@@ -0,0 +1,91 @@
+#include <string.h>
+#include "tusb.h"
+#include "hid_report.h"
+
+// HID gamepad polled every 1 ms, plus a CDC serial port for the framed
+// protocol
+#define USB_VID 0xCAFE
+#define USB_PID 0x4005
+#define EPNUM_HID       0x81
+#define EPNUM_CDC_NOTIF 0x82
+#define EPNUM_CDC_OUT   0x03
+#define EPNUM_CDC_IN    0x83
+
+enum { ITF_NUM_HID, ITF_NUM_CDC, ITF_NUM_CDC_DATA, ITF_NUM_TOTAL };
+
+static const tusb_desc_device_t desc_device = {
+    .bLength = sizeof(tusb_desc_device_t),
+    .bDescriptorType = TUSB_DESC_DEVICE,
+    .bcdUSB = 0x0200,
+    // Interface association, needed by the CDC pair
+    .bDeviceClass = TUSB_CLASS_MISC,
+    .bDeviceSubClass = MISC_SUBCLASS_COMMON,
+    .bDeviceProtocol = MISC_PROTOCOL_IAD,
+    .bMaxPacketSize0 = CFG_TUD_ENDPOINT0_SIZE,
+    .idVendor = USB_VID,
+    .idProduct = USB_PID,
+    .bcdDevice = 0x0100,
+    .iManufacturer = 0x01,
+    .iProduct = 0x02,
+    .iSerialNumber = 0x03,
+    .bNumConfigurations = 0x01,
+};
+
+static const uint8_t desc_hid_report[] = {
+    HID_REPORT_DESC
+};
+
+#define CONFIG_TOTAL_LEN (TUD_CONFIG_DESC_LEN + TUD_HID_DESC_LEN + TUD_CDC_DESC_LEN)
+
+static const uint8_t desc_configuration[] = {
+    TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, 0x00, 100),
+    TUD_HID_DESCRIPTOR(ITF_NUM_HID, 0, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_report),
+                       EPNUM_HID, CFG_TUD_HID_EP_BUFSIZE, 1),
+    TUD_CDC_DESCRIPTOR(ITF_NUM_CDC, 4, EPNUM_CDC_NOTIF, 8, EPNUM_CDC_OUT, EPNUM_CDC_IN,
+                       CFG_TUD_CDC_EP_BUFSIZE),
+};
+
+static const char *const string_desc[] = {
+    NULL,  // language, handled below
+    "Insper",
+    "Arcadestick",
+    "0001",
+    "Arcadestick serial",
+};
+
+const uint8_t *tud_descriptor_device_cb(void) {
+    return (const uint8_t *)&desc_device;
+}
+
+const uint8_t *tud_hid_descriptor_report_cb(uint8_t instance) {
+    (void)instance;
+    return desc_hid_report;
+}
+
+const uint8_t *tud_descriptor_configuration_cb(uint8_t index) {
+    (void)index;
+    return desc_configuration;
+}
+
+const uint16_t *tud_descriptor_string_cb(uint8_t index, uint16_t langid) {
+    static uint16_t desc_str[32 + 1];
+    size_t count;
+
+    (void)langid;
+    if (index == 0) {
+        desc_str[1] = 0x0409;  // English
+        count = 1;
+    } else {
+        if (index >= sizeof(string_desc) / sizeof(string_desc[0]))
+            return NULL;
+        const char *str = string_desc[index];
+        count = strlen(str);
+        if (count > 32)
+            count = 32;
+        for (size_t i = 0; i < count; i++)
+            desc_str[1 + i] = str[i];
+    }
+
+    desc_str[0] = (uint16_t)((TUSB_DESC_STRING << 8) | (2 * count + 2));
+    return desc_str;
+}
@@ -0,0 +1,100 @@
+#include <string.h>
+#include "usb_hid.h"
+#include "hid_report.h"
+#include "common.h"
+#include "event_bus.h"
+#include "transport.h"
+#include "tusb.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define USB_QUEUE_LEN 16
+
+// The report is built from bus_get_state(); the queue only wakes the task
+static bus_subscriber_t usb_sub;
+static event_t usb_storage[USB_QUEUE_LEN];
+static TaskHandle_t usb_task_handle = NULL;
+
+void usb_hid_init(void) {
+    bus_subscribe(&usb_sub, EV_MASK(EV_SRC_BUTTON) | EV_MASK(EV_SRC_FSR) | EV_MASK(EV_SRC_POT),
+                  usb_storage, USB_QUEUE_LEN);
+}
+
+void usb_hid_wake(void) {
+    if (usb_task_handle != NULL)
+        xTaskNotifyGive(usb_task_handle);
+}
+
+// TinyUSB queued an event (bus reset, setup packet, report sent...):
+// tud_task() has work to do
+void tud_event_hook_cb(uint8_t rhport, uint32_t eventid, bool in_isr) {
+    (void)rhport;
+    (void)eventid;
+
+    if (usb_task_handle == NULL)
+        return;
+    if (in_isr) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(usb_task_handle, &woken);
+        portYIELD_FROM_ISR(woken);
+    } else {
+        xTaskNotifyGive(usb_task_handle);
+    }
+}
+
+uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type,
+                               uint8_t *buffer, uint16_t reqlen) {
+    (void)instance;
+    (void)report_id;
+    (void)report_type;
+    (void)buffer;
+    (void)reqlen;
+    return 0;
+}
+
+void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type,
+                           uint8_t const *buffer, uint16_t bufsize) {
+    (void)instance;
+    (void)report_id;
+    (void)report_type;
+    (void)buffer;
+    (void)bufsize;
+}
+
+void usb_hid_task(void *p) {
+    hid_report_t report, last;
+    input_state_t st;
+    event_t ev;
+    bool sent_once = false;
+
+    usb_task_handle = xTaskGetCurrentTaskHandle();
+    usb_sub.notify = usb_task_handle;
+    tud_init(BOARD_TUD_RHPORT);
+
+    while (1) {
+        // Woken by the bus or by the USB IRQ. The host polls the endpoint
+        // every 1 ms, so a changed report goes out on the next frame.
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        tud_task();
+        transport_cdc_service();
+
+        while (bus_receive(&usb_sub, &ev, 0))
+            ;
+        usb_sub.overflowed = false;
+
+        if (!tud_mounted()) {
+            sent_once = false;
+            continue;
+        }
+
+        bus_get_state(&st);
+        hid_pack_report(&st, &report);
+        // Busy endpoint: the report-complete event wakes us to retry
+        if ((!sent_once || memcmp(&report, &last, sizeof(report)) != 0) && tud_hid_ready()) {
+            if (tud_hid_report(0, &report, sizeof(report))) {
+                last = report;
+                sent_once = true;
+            }
+        }
+    }
+}
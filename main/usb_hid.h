@@ -0,0 +1,11 @@
+#ifndef USB_HID_H
+#define USB_HID_H
+
+// Native USB gamepad: buttons, FSR level and pot straight from the event
+// bus, no host script needed. Call usb_hid_init() before the scheduler.
+void usb_hid_init(void);
+void usb_hid_task(void *p);
+// Wakes usb_hid_task, e.g. when the CDC transport queued bytes
+void usb_hid_wake(void);
+
+#endif
@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+"""Gera main/proto_frames.h e python/proto_frames.py a partir de schema.json.
+
+O layout dos quadros fica descrito uma vez só; o firmware usa as funções
+proto_pack_*() geradas e o script Python usa os struct.Struct gerados.
+Gera também tests/proto_frames_roundtrip.c, que empacota cada quadro com
+as funções em C para tests/test_proto_frames_host.py conferir com os
+struct.Struct. Rode de novo depois de qualquer mudança no schema:
+
+    python3 protocol/gerar.py
+"""
+
+import json
+import os
+
+RAIZ = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SCHEMA = os.path.join(RAIZ, 'protocol', 'schema.json')
+SAIDA_C = os.path.join(RAIZ, 'main', 'proto_frames.h')
+SAIDA_PY = os.path.join(RAIZ, 'python', 'proto_frames.py')
+SAIDA_TESTE = os.path.join(RAIZ, 'tests', 'proto_frames_roundtrip.c')
+
+AVISO = "Gerado por protocol/gerar.py a partir de protocol/schema.json. Não edite."
+
+TIPOS = {
+    # tipo: (tipo em C, bytes, formato struct)
+    'u8': ('uint8_t', 1, 'B'),
+    'u16': ('uint16_t', 2, 'H'),
+    'i16': ('int16_t', 2, 'h'),
+    'u32': ('uint32_t', 4, 'I'),
+}
+
+
+def layout_quadro(quadro):
+    """Campos na ordem do fio: o código fixo, se houver, vem logo depois do seq."""
+    campos = [tuple(c) for c in quadro['fields']]
+    if 'code' in quadro:
+        campos.insert(1, ('code', 'u8', 'PROTO_CODE_' + quadro['code']))
+    return campos
+
+
+def tamanho(campos):
+    return sum(TIPOS[c[1]][1] for c in campos)
+
+
+def gerar_c(schema):
+    linhas = [f"// {AVISO}", "#ifndef PROTO_FRAMES_H", "#define PROTO_FRAMES_H", "",
+              "#include <stdint.h>", "#include <stddef.h>", "",
+              f"#define PROTO_VERSION {schema['version']}", ""]
+
+    for grupo in schema['constants']:
+        linhas.append(f"// {grupo['doc']}")
+        largura = max(len(n) for n in grupo['values'])
+        for nome, valor in grupo['values'].items():
+            linhas.append(f"#define PROTO_{grupo['group']}_{nome.ljust(largura)} {valor}")
+        linhas.append("")
+
+    linhas.append("// Payload writers, big endian; return the payload length")
+    for quadro in schema['frames']:
+        campos = layout_quadro(quadro)
+        nome = quadro['name']
+        if 'doc' in quadro:
+            linhas.append(f"// {quadro['doc']}")
+        linhas.append(f"#define PROTO_FRAME_{nome.upper()}_LEN {tamanho(campos)}")
+        args = ", ".join(f"{TIPOS[t][0]} {n}" for n, t, *fixo in campos if not fixo)
+        linhas.append(f"static inline size_t proto_pack_{nome}(uint8_t *out, {args}) {{")
+        pos = 0
+        for n, t, *fixo in campos:
+            valor = fixo[0] if fixo else n
+            n = TIPOS[t][1]
+            if n == 1:
+                linhas.append(f"    out[{pos}] = {valor};")
+            else:
+                tipo_u = f"uint{8 * n}_t"
+                for i in range(n):
+                    desloc = 8 * (n - 1 - i)
+                    if desloc:
+                        linhas.append(f"    out[{pos + i}] = (({tipo_u}){valor} >> {desloc}) & 0xFF;")
+                    else:
+                        linhas.append(f"    out[{pos + i}] = ({tipo_u}){valor} & 0xFF;")
+            pos += n
+        linhas.append(f"    return {pos};")
+        linhas.append("}")
+        linhas.append("")
+
+    linhas.append("// Command lengths, including the command byte")
+    for cmd in schema['commands']:
+        linhas.append(f"#define PROTO_CMD_{cmd['name'].upper()}_LEN {1 + tamanho(cmd['fields'])}")
+    linhas.append("")
+
+    linhas.append("// Field order of the PROTO_CODE_STATS reply, 16 bits each")
+    linhas.append("enum {")
+    for nome, _ in schema['stats']:
+        linhas.append(f"    PROTO_STAT_{nome},")
+    linhas.append("    PROTO_STAT_COUNT")
+    linhas.append("};")
+    linhas.append("")
+    linhas.append("#endif")
+    return "\n".join(linhas) + "\n"
+
+
+def formato_struct(campos):
+    return '>' + ''.join(TIPOS[c[1]][2] for c in campos)
+
+
+def gerar_py(schema):
+    linhas = [f'"""{AVISO}"""', "", "import struct", "",
+              f"VERSAO_PROTOCOLO = {schema['version']}", ""]
+
+    for grupo in schema['constants']:
+        linhas.append(f"# {grupo['doc']}")
+        for nome, valor in grupo['values'].items():
+            linhas.append(f"{grupo['group']}_{nome} = {valor}")
+        linhas.append("")
+
+    linhas.append("# Quadros dispositivo -> host. unpack_from lê direto do buffer, sem cópia.")
+    for quadro in schema['frames']:
+        campos = layout_quadro(quadro)
+        nome = quadro['name'].upper()
+        nomes = ", ".join(repr(c[0]) for c in campos)
+        linhas.append(f"{nome} = struct.Struct('{formato_struct(campos)}')  # {nomes}")
+    linhas.append("")
+
+    linhas.append("# Comandos host -> dispositivo: [cmd, args...]")
+    for cmd in schema['commands']:
+        nome = cmd['name'].upper()
+        campos = [('cmd', 'u8')] + [tuple(c) for c in cmd['fields']]
+        linhas.append(f"CMD_{nome}_STRUCT = struct.Struct('{formato_struct(campos)}')")
+    for cmd in schema['commands']:
+        nome = cmd['name']
+        args = [c[0] for c in cmd['fields']]
+        linhas.append("")
+        linhas.append("")
+        linhas.append(f"def payload_{nome}({', '.join(args)}):")
+        valores = ', '.join([f"CMD_{nome.upper()}"] + args)
+        linhas.append(f"    return CMD_{nome.upper()}_STRUCT.pack({valores})")
+    linhas.append("")
+    linhas.append("")
+    linhas.append("# Campos do quadro CODE_STATS, 16 bits cada")
+    campos_stats = ", ".join(repr(py) for _, py in schema['stats'])
+    linhas.append(f"CAMPOS_STATS = ({campos_stats})")
+    return "\n".join(linhas) + "\n"
+
+
+def valor_teste(tipo, k):
+    """Valor do k-ésimo campo no teste de ida e volta: bit mais alto ligado
+    (pega erro de sinal) e bytes diferentes (pega erro de ordem)."""
+    if tipo == 'i16':
+        return -0x1234 - k
+    bits = 8 * TIPOS[tipo][1]
+    return (1 << (bits - 1)) + (0x01010101 * (k + 1) + k) % (1 << (bits - 1))
+
+
+def gerar_teste(schema):
+    """Programa que imprime uma linha por quadro: nome, valores e bytes em hex."""
+    linhas = [f"// {AVISO}", "#include <stdio.h>", '#include "proto_frames.h"', "",
+              "static void dump(const char *name, const long long *values, int count,",
+              "                 const uint8_t *out, size_t len) {",
+              '    printf("%s", name);',
+              "    for (int i = 0; i < count; i++)",
+              '        printf(" %lld", values[i]);',
+              '    printf(" ");',
+              "    for (size_t i = 0; i < len; i++)",
+              '        printf("%02x", out[i]);',
+              '    printf("\\n");',
+              "}", "",
+              "int main(void) {",
+              "    uint8_t out[64];",
+              "    size_t len;", ""]
+    for quadro in schema['frames']:
+        campos = layout_quadro(quadro)
+        nome = quadro['name']
+        valores, args = [], []
+        for k, (n, t, *fixo) in enumerate(campos):
+            if fixo:
+                valores.append(fixo[0])
+            else:
+                v = valor_teste(t, k)
+                valores.append(str(v))
+                args.append(str(v))
+        linhas.append("    {")
+        linhas.append(f"        static const long long values[] = {{{', '.join(valores)}}};")
+        linhas.append(f"        len = proto_pack_{nome}(out, {', '.join(args)});")
+        linhas.append(f"        if (len != PROTO_FRAME_{nome.upper()}_LEN)")
+        linhas.append("            return 1;")
+        linhas.append(f'        dump("{nome}", values, {len(campos)}, out, len);')
+        linhas.append("    }")
+    for cmd in schema['commands']:
+        linhas.append(f'    printf("cmd_{cmd["name"]} %d\\n", PROTO_CMD_{cmd["name"].upper()}_LEN);')
+    for grupo in schema['constants']:
+        for nome in grupo['values']:
+            linhas.append(f'    printf("{grupo["group"]}_{nome} %d\\n", PROTO_{grupo["group"]}_{nome});')
+    linhas.append("    return 0;")
+    linhas.append("}")
+    return "\n".join(linhas) + "\n"
+
+
+def main():
+    with open(SCHEMA, encoding='utf-8') as f:
+        schema = json.load(f)
+    with open(SAIDA_C, 'w', encoding='utf-8') as f:
+        f.write(gerar_c(schema))
+    with open(SAIDA_PY, 'w', encoding='utf-8') as f:
+        f.write(gerar_py(schema))
+    with open(SAIDA_TESTE, 'w', encoding='utf-8') as f:
+        f.write(gerar_teste(schema))
+    print(f"{SAIDA_C}\n{SAIDA_PY}\n{SAIDA_TESTE}")
+
+
+if __name__ == '__main__':
+    main()
@@ -4,9 +4,11 @@ import serial
 import tkinter as tk
 from tkinter import ttk
 from tkinter import messagebox
-from time import sleep
+from time import sleep, monotonic
 import keyboard
 
+import protocol
+
 # def move_mouse(axis, value):
 #     """Move o mouse de acordo com o eixo e valor recebidos."""
 #     if axis == 0:
@@ -34,45 +36,349 @@ def map_codigo_para_tecla(codigo):
     }
     return mapa.get(codigo, None)
 
-def controle(ser):
-    last_pot_value = None
-
-    while True:
-        b = ser.read(size=1)
-        if not b:
-            continue
-
-        axis = b[0]
-        value_bytes = ser.read(2)
-        end_byte = ser.read(1)
+def tratar_controle(codigo, payload, estado):
+    """Respostas do dispositivo aos comandos enviados pelo host."""
+    if codigo == protocol.CODE_PONG and len(payload) == protocol.PONG.size:
+        _, _, token = protocol.PONG.unpack_from(payload)
+        enviado = estado['pings'].pop(token, None)
+        if enviado is not None:
+            estado['rtt'] = monotonic() - enviado
+    elif codigo == protocol.CODE_STATS:
+        estado['stats_dispositivo'] = protocol.parse_stats(payload)
+    elif codigo == protocol.CODE_CMD_OK and len(payload) == protocol.CMD_OK.size:
+        _, _, cmd, status = protocol.CMD_OK.unpack_from(payload)
+        if status != protocol.STATUS_OK:
+            print(f"Comando 0x{cmd:02X} recusado pelo dispositivo")
+    elif codigo == protocol.CODE_STATE and len(payload) == protocol.STATE.size:
+        aplicar_estado(payload, estado)
+        if RELATORIO_MS:
+            # Intervalo entre relatórios como o host vê, com o link no meio
+            if estado['ultimo_relatorio'] is not None:
+                estado['intervalos'].append(estado['t_rx'] - estado['ultimo_relatorio'])
+            estado['ultimo_relatorio'] = estado['t_rx']
+    elif codigo == protocol.CODE_HELLO:
+        tratar_hello(payload, estado)
+    elif codigo == protocol.CODE_PROBE and len(payload) == protocol.PROBE.size:
+        # Volta na hora: o dispositivo mede o RTT e ajusta a janela de lote
+        _, _, at_us = protocol.PROBE.unpack_from(payload)
+        estado['saida'].append(protocol.cmd_echo(at_us, estado['pacotes'].intervalo_us()))
+    elif codigo == protocol.CODE_LINKS:
+        estado['links'] = protocol.parse_links(payload)
+    elif codigo == protocol.CODE_TIME and len(payload) == protocol.TIME.size:
+        _, _, token, rx_us, tx_us = protocol.TIME.unpack_from(payload)
+        enviado = estado['sincronias'].pop(token, None)
+        if enviado is not None:
+            estado['relogio'].adicionar(enviado, rx_us, tx_us, estado['t_rx'])
+    # CODE_HEARTBEAT não tem dados: só chegar já alimenta o watchdog
+
+
+def tratar_hello(payload, estado):
+    """Escolhe o formato dos quadros a partir das capacidades do dispositivo."""
+    capacidades = protocol.parse_hello(payload)
+    if capacidades is None:
+        return
+    estado['capacidades'] = capacidades
+    # Depois de um reinício o seq recomeça do zero
+    estado['bordas'].esquecer()
+    if capacidades['versao'] != protocol.VERSAO_PROTOCOLO:
+        print(f"Protocolo v{capacidades['versao']} no dispositivo, "
+              f"v{protocol.VERSAO_PROTOCOLO} no host: usando o formato original")
+
+    sem_tecla = [c for c in capacidades['botoes'] + capacidades['fsr_codigos']
+                 if not map_codigo_para_tecla(c)]
+    if sem_tecla:
+        print("Códigos sem tecla no host:", ", ".join(f"0x{c:02X}" for c in sem_tecla))
+
+    formato = protocol.escolher_formato(capacidades, protocol.FMT_FEC if USAR_FEC else 0)
+    # O dispositivo só troca depois de ler o comando: alguns quadros no
+    # formato anterior podem se perder na virada
+    estado['decoder'].fec = bool(formato & protocol.FMT_FEC)
+    # Mudar o formato também faz o dispositivo mandar um quadro-chave
+    estado['analogico'].invalidar()
+    estado['saida'].append(protocol.cmd_set_format(formato))
+    if RELATORIO_MS:
+        estado['saida'].append(protocol.cmd_set_report(RELATORIO_MS))
+    if LOTE_LIMITE_MS:
+        estado['saida'].append(protocol.cmd_set_threshold(protocol.THRESH_BATCH_LIMIT_MS, LOTE_LIMITE_MS))
+    print(f"Dispositivo v{capacidades['versao']}, formato 0x{formato:02X}")
+
+
+def aplicar_estado(payload, estado):
+    """Acerta as teclas do host com o estado completo enviado pelo dispositivo.
+
+    Corrige qualquer borda perdida no caminho: solta o que o dispositivo
+    não segura mais e aperta o que ficou faltando.
+    """
+    pressionados, pot = protocol.parse_state(payload)
+    # Bordas que passaram na frente deste quadro (fila de bordas) são mais
+    # novas que ele: nesses códigos vale o que o host já aplicou
+    validos = estado['bordas'].estado(payload[0], range(1, 16))
+    pressionados = ({c for c in pressionados if c in validos} |
+                    {c for c in estado['pressionados'] if c not in validos})
+    for codigo in estado['pressionados'] - pressionados:
+        for tecla in map_codigo_para_tecla(codigo) or []:
+            keyboard.release(tecla)
+    for codigo in pressionados - estado['pressionados']:
+        for tecla in map_codigo_para_tecla(codigo) or []:
+            keyboard.press(tecla)
+    estado['pressionados'] = {c for c in pressionados if map_codigo_para_tecla(c)}
+    # Só registra o valor: o volume segue apenas as mudanças de verdade
+    estado['pot'] = pot
+
+
+def aplicar_pot(value, estado):
+    # Controle de volume baseado na mudança de valor do potenciômetro
+    last_pot_value = estado.get('pot')
+    if last_pot_value is not None:
+        delta = value - last_pot_value
+        if abs(delta) > 3:  # Evita mudanças muito pequenas
+            if delta > 0:
+                keyboard.send(-175)  # Volume Up
+            else:
+                keyboard.send(-174)  # Volume Down
+    estado['pot'] = value
+
+
+def tratar_quadro(payload, estado):
+    """Aplica um quadro já validado: [seq, código, dados...]."""
+    if len(payload) < 2:
+        return
 
-        if len(value_bytes) == 2 and end_byte and end_byte[0] == 0xFF:
-            value = int.from_bytes(value_bytes, byteorder='big', signed=True)
+    # Toda borda é confirmada, até as repetidas: o ACK anterior pode ter se perdido
+    if protocol.eh_borda(payload[1]):
+        estado['ack'] = payload[0]
 
-            if axis == 0x00:
-                # Controle de volume baseado na mudança de valor do potenciômetro
-                if last_pot_value is not None:
-                    delta = value - last_pot_value
-                    if abs(delta) > 3:  # Evita mudanças muito pequenas
-                        if delta > 0:
-                            keyboard.send(-175)  # Volume Up
-                        else:
-                            keyboard.send(-174)  # Volume Down
-                last_pot_value = value
+    if not estado['seq'].update(payload[0]):
+        return
+    estado['bordas'].avancar(payload[0])
 
-            elif axis >= 0x01:
-                soltar = axis & 0x80
-                codigo_real = axis & 0x7F
-                teclas = map_codigo_para_tecla(codigo_real)
-                if teclas:
-                    for tecla in teclas:
-                        if soltar:
-                            keyboard.release(tecla)
-                        else:
-                            keyboard.press(tecla)
+    axis = payload[1]
+    if axis in protocol.CODIGOS_CONTROLE:
+        tratar_controle(axis, payload, estado)
+        return
+    if axis in protocol.CODIGOS_REGISTRO:
+        for canal, valor in estado['analogico'].feed(payload[1:]):
+            if canal == 0:
+                aplicar_pot(valor, estado)
+        return
 
+    if len(payload) == protocol.EVENT_TIMED.size:
+        _, _, value, at_us, fila_us = protocol.EVENT_TIMED.unpack_from(payload)
+    elif len(payload) == protocol.EVENT.size:
+        _, _, value = protocol.EVENT.unpack_from(payload)
+        at_us = None
+    else:
+        return
 
+    if axis == 0x00:
+        aplicar_pot(value, estado)
+    elif axis >= 0x01:
+        soltar = axis & 0x80
+        codigo_real = axis & 0x7F
+        if not estado['bordas'].aceitar(codigo_real, payload[0]):
+            # Reenvio que chegou depois de algo mais novo para este código
+            return
+        teclas = map_codigo_para_tecla(codigo_real)
+        if teclas:
+            for tecla in teclas:
+                if soltar:
+                    keyboard.release(tecla)
+                else:
+                    keyboard.press(tecla)
+            if soltar:
+                estado['pressionados'].discard(codigo_real)
+            else:
+                estado['pressionados'].add(codigo_real)
+        if at_us is not None and estado['relogio'].sincronizado():
+            # Do bus_post até a saída do dispositivo, daí até a leitura da
+            # serial no host e, por fim, até a tecla chegar ao sistema
+            fila = fila_us / 1e6
+            link = estado['t_rx'] - estado['relogio'].para_host(at_us) - fila
+            estado['latencia'].registrar(fila=fila, link=max(link, 0.0),
+                                         host=monotonic() - estado['t_rx'])
+
+
+def soltar_tudo(estado):
+    """Solta todas as teclas que o host está segurando."""
+    for codigo in estado['pressionados']:
+        for tecla in map_codigo_para_tecla(codigo) or []:
+            keyboard.release(tecla)
+    estado['pressionados'].clear()
+
+
+INTERVALO_ESTATISTICAS = 5.0  # segundos
+# Sem nenhum quadro (nem heartbeat) por esse tempo, o link é dado como morto.
+# O dispositivo manda heartbeat a cada 250 ms quando está parado.
+TIMEOUT_LINK = 1.0  # segundos
+ESPERA_REORDEM = 0.05  # segundos
+# O HC-06 pausa o envio depois de 2 s sem keepalive do host
+INTERVALO_KEEPALIVE = 0.5  # segundos
+INTERVALO_SINCRONIA = 1.0  # segundos
+# FEC custa 3 bytes por quadro; ligue em ambientes com muita interferência
+# (eventos com vários links 2,4 GHz)
+USAR_FEC = False
+# Relatórios de estado em intervalo fixo (2, 4, 8 ms...) em vez de eventos;
+# 0 deixa o dispositivo mandar cada evento assim que acontece
+RELATORIO_MS = 0
+# Quanto o dispositivo pode segurar o primeiro evento de um lote para que
+# os seguintes vão no mesmo pacote de rádio (até 50 ms); 0 desliga
+LOTE_LIMITE_MS = 0
+
+
+def resumo_link(estado, decoder):
+    resumo = estado['seq'].resumo(decoder)
+
+    # Vazão efetiva medida desde o último resumo
+    agora = monotonic()
+    inicio, bytes_antes, quadros_antes = estado['janela_vazao']
+    dt = agora - inicio
+    if dt > 0:
+        bps = (decoder.bytes_recebidos - bytes_antes) / dt
+        qps = (decoder.quadros_ok - quadros_antes) / dt
+        resumo += f" | {qps:.0f} quadros/s, {bps:.0f} B/s"
+    estado['janela_vazao'] = (agora, decoder.bytes_recebidos, decoder.quadros_ok)
+
+    analogico = estado['analogico'].resumo()
+    if analogico:
+        resumo += f" | {analogico}"
+    if estado.get('rtt') is not None:
+        resumo += f" | RTT {estado['rtt'] * 1000:.0f} ms"
+    if estado['intervalos']:
+        intervalos = estado['intervalos']
+        media = sum(intervalos) / len(intervalos)
+        jitter = max(abs(i - RELATORIO_MS / 1000) for i in intervalos)
+        resumo += f" | relatórios a cada {media * 1000:.2f} ms, jitter {jitter * 1000:.2f} ms no host"
+        intervalos.clear()
+    for parte in (estado['relogio'].resumo(), estado['latencia'].resumo()):
+        if parte:
+            resumo += f" | {parte}"
+    stats = estado.get('stats_dispositivo')
+    pacote_us = estado['pacotes'].intervalo_us()
+    if pacote_us:
+        resumo += f" | pacotes de rádio a cada ~{pacote_us / 1000:.1f} ms"
+    if stats:
+        print("Dispositivo:", stats)
+        if stats.get('baud_x100'):
+            resumo += f" | {stats['baud_x100'] * 100} baud"
+    for link in estado.get('links') or []:
+        situacao = 'ok' if link['pronto'] else 'fora'
+        print(f"Link {link['nome']}: {situacao}, {link['pendente']} B na fila, "
+              f"{link['drops']} lotes perdidos, pior latência {link['latencia_us']} us")
+    return resumo
+
+
+def controle(ser, mostrar_estatisticas=None, mostrar_link=None, timeout_link=TIMEOUT_LINK):
+    decoder = protocol.FrameDecoder()
+    estado = {'seq': protocol.SequenceTracker(), 'pings': {}, 'rtt': None,
+              'janela_vazao': (monotonic(), 0, 0), 'pressionados': set(),
+              'analogico': protocol.AnalogDecoder(), 'capacidades': None, 'saida': [],
+              'relogio': protocol.RelogioDispositivo(), 'sincronias': {},
+              'latencia': protocol.LatenciaBordas(), 't_rx': monotonic(),
+              'decoder': decoder, 'ultimo_relatorio': None, 'intervalos': [],
+              'pacotes': protocol.Pacotizacao(), 'bordas': protocol.OrdemBordas()}
+    proximo_resumo = monotonic() + INTERVALO_ESTATISTICAS
+    proximo_keepalive = monotonic()
+    proxima_sincronia = monotonic()
+    ultimo_quadro = monotonic()
+    link_ok = True
+    proximo_hello = None
+    token = 0
+    perda_desde = None
+    perdidos_confirmados = 0
+    # O dispositivo também se anuncia sozinho ao ligar. Sem resposta
+    # (firmware antigo), tudo continua no formato original.
+    ser.write(protocol.cmd_hello())
 
+    while True:
+        data = ser.read(ser.in_waiting or 1)
+        estado['t_rx'] = monotonic()
+        if data:
+            estado['pacotes'].chegada(estado['t_rx'])
+        payloads = decoder.feed(data)
+        if payloads:
+            ultimo_quadro = monotonic()
+            if not link_ok:
+                link_ok = True
+                estado['seq'].resync()
+                estado['bordas'].esquecer()
+                # Estado completo logo de cara, sem esperar o próximo
+                # periódico. O dispositivo pode ter reiniciado no formato
+                # original, então o formato é negociado de novo.
+                estado['analogico'].invalidar()
+                ser.write(protocol.cmd_resync())
+                ser.write(protocol.cmd_hello())
+                print("Link restabelecido")
+                if mostrar_link:
+                    mostrar_link(True)
+
+        perdidos_antes = estado['seq'].perdidos
+        estado['ack'] = None
+        for payload in payloads:
+            tratar_quadro(payload, estado)
+        for comando in estado['saida']:
+            ser.write(comando)
+        estado['saida'].clear()
+        if estado['ack'] is not None:
+            # Um ACK por leitura cobre a última borda e as 8 anteriores
+            ack = estado['ack']
+            ser.write(protocol.cmd_ack(ack, estado['seq'].mascara_ack(ack)))
+        # Bordas ultrapassam os outros quadros no dispositivo, então um
+        # salto de seq pode ser só reordenação: espera um pouco antes de
+        # tratar como perda
+        if estado['seq'].perdidos > perdidos_antes and perda_desde is None:
+            perda_desde = monotonic()
+        if perda_desde is not None and monotonic() - perda_desde > ESPERA_REORDEM:
+            perda_desde = None
+            if estado['seq'].perdidos > perdidos_confirmados:
+                # Algum quadro sumiu de verdade: pode ter sido uma borda ou
+                # um delta do pot. O pedido de estado também traz um
+                # quadro-chave analógico.
+                estado['analogico'].invalidar()
+                ser.write(protocol.cmd_resync())
+            perdidos_confirmados = estado['seq'].perdidos
+
+        # Avisa o dispositivo que ainda tem alguém lendo. Sai mesmo com o
+        # link morto, senão o dispositivo nunca voltaria a enviar.
+        if monotonic() >= proximo_keepalive:
+            proximo_keepalive = monotonic() + INTERVALO_KEEPALIVE
+            ser.write(protocol.cmd_keepalive())
+
+        # Sincronia de relógio contínua: acompanha a deriva do cristal
+        if monotonic() >= proxima_sincronia:
+            proxima_sincronia = monotonic() + INTERVALO_SINCRONIA
+            token = (token + 1) & 0xFFFF
+            estado['sincronias'] = {token: monotonic()}
+            ser.write(protocol.cmd_time(token))
+
+        # Watchdog: com o link morto, nenhuma tecla pode ficar presa
+        if link_ok and monotonic() - ultimo_quadro > timeout_link:
+            link_ok = False
+            proximo_hello = monotonic()
+            soltar_tudo(estado)
+            print("Link perdido: teclas soltas")
+            if mostrar_link:
+                mostrar_link(False)
+
+        # Um dispositivo que reiniciou voltou ao formato original. Com FEC
+        # ligado, o decoder só aceita dele um HELLO sem paridade, então
+        # pede um de novo enquanto nada passa.
+        if not link_ok and monotonic() >= proximo_hello:
+            proximo_hello = monotonic() + timeout_link
+            ser.write(protocol.cmd_hello())
+
+        if monotonic() >= proximo_resumo:
+            proximo_resumo += INTERVALO_ESTATISTICAS
+            resumo = resumo_link(estado, decoder)
+
+            # Mede a latência de ida e volta e pede os contadores do dispositivo
+            token = (token + 1) & 0xFFFF
+            estado['pings'] = {token: monotonic()}
+            ser.write(protocol.cmd_ping(token))
+            ser.write(protocol.cmd_get_stats())
+            ser.write(protocol.cmd_get_links())
+            print(resumo)
+            if mostrar_estatisticas:
+                mostrar_estatisticas(resumo)
 
 
 def serial_ports():
@@ -120,14 +426,28 @@ def conectar_porta(port_name, root, botao_conectar, status_label, mudar_cor_circ
         return
 
     try:
-        ser = serial.Serial(port_name, 115200, timeout=1)
+        # Timeout curto para o watchdog do link rodar mesmo sem dados
+        ser = serial.Serial(port_name, 115200, timeout=0.05)
         status_label.config(text=f"Conectado em {port_name}", foreground="green")
         mudar_cor_circulo("green")
         botao_conectar.config(text="Conectado")  # Update button text to indicate connection
         root.update()
 
+        def mostrar_estatisticas(resumo):
+            status_label.config(text=f"{port_name}: {resumo}")
+            root.update()
+
+        def mostrar_link(ok):
+            if ok:
+                status_label.config(text=f"Conectado em {port_name}", foreground="green")
+                mudar_cor_circulo("green")
+            else:
+                status_label.config(text=f"{port_name}: sem resposta do controle", foreground="orange")
+                mudar_cor_circulo("orange")
+            root.update()
+
         # Inicia o loop de leitura (bloqueante).
-        controle(ser)
+        controle(ser, mostrar_estatisticas, mostrar_link)
 
     except KeyboardInterrupt:
         print("Encerrando via KeyboardInterrupt.")
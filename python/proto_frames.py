@@ -0,0 +1,152 @@
+"""Gerado por protocol/gerar.py a partir de protocol/schema.json. Não edite."""
+
+import struct
+
+VERSAO_PROTOCOLO = 1
+
+# Device -> host control codes, after [seq]. Input codes are 0x00-0x0F (press/analog) and 0x80-0x8F (release).
+CODE_PONG = 0x70
+CODE_STATS = 0x71
+CODE_CMD_OK = 0x72
+CODE_HEARTBEAT = 0x73
+CODE_STATE = 0x74
+CODE_HELLO = 0x75
+CODE_LINKS = 0x76
+CODE_TIME = 0x77
+CODE_PROBE = 0x78
+
+# Host -> device commands: [cmd, args...]
+CMD_PING = 0x01
+CMD_SET_SCAN = 0x02
+CMD_SET_THRESH = 0x03
+CMD_REMAP = 0x04
+CMD_GET_STATS = 0x05
+CMD_RESYNC = 0x06
+CMD_ACK = 0x07
+CMD_SET_FORMAT = 0x08
+CMD_HELLO = 0x09
+CMD_GET_LINKS = 0x0A
+CMD_KEEPALIVE = 0x0B
+CMD_TIME = 0x0C
+CMD_SET_REPORT = 0x0D
+CMD_ECHO = 0x0E
+
+# Transport ids in the LINKS reply
+LINK_HC06 = 0
+LINK_CDC = 1
+
+# Wire format options the host can turn on; 0 is the original format
+FMT_COMPACT_ANALOG = 0x01
+FMT_EDGE_TIME = 0x02
+FMT_FEC = 0x04
+
+# Compact analog records: DELTA | channel + zig-zag varint, KEY | channel + absolute value, RUN | channel + count + count varints
+REC_DELTA = 0xC0
+REC_KEY = 0xD0
+REC_RUN = 0xE0
+
+# SET_SCAN targets
+SCAN_BUTTON = 0
+SCAN_POT = 1
+SCAN_FSR = 2
+SCAN_HEARTBEAT = 3
+
+# SET_THRESH ids
+THRESH_FSR_PRESS = 0
+THRESH_FSR_LVL2 = 1
+THRESH_FSR_LVL3 = 2
+THRESH_POT_DEADBAND = 3
+THRESH_BATCH_LIMIT_MS = 4
+THRESH_ANALOG_HOLD_MS = 5
+
+# CMD_OK status
+STATUS_OK = 0
+STATUS_ERR = 1
+
+# Quadros dispositivo -> host. unpack_from lê direto do buffer, sem cópia.
+EVENT = struct.Struct('>BBh')  # 'seq', 'code', 'value'
+EVENT_TIMED = struct.Struct('>BBhIH')  # 'seq', 'code', 'value', 'at_us', 'queue_us'
+HEARTBEAT = struct.Struct('>BB')  # 'seq', 'code'
+STATE = struct.Struct('>BBHBh')  # 'seq', 'code', 'pressed', 'fsr', 'pot'
+PONG = struct.Struct('>BBH')  # 'seq', 'code', 'token'
+CMD_OK = struct.Struct('>BBBB')  # 'seq', 'code', 'cmd', 'status'
+HELLO = struct.Struct('>BBBBBBBBBB')  # 'seq', 'code', 'version', 'formats', 'channels', 'tick_ms', 'heartbeat_10ms', 'fsr_first', 'fsr_levels', 'button_count'
+TIME = struct.Struct('>BBHII')  # 'seq', 'code', 'token', 'rx_us', 'tx_us'
+PROBE = struct.Struct('>BBI')  # 'seq', 'code', 'at_us'
+LINK = struct.Struct('>BBHHH')  # 'ident', 'ready', 'pending', 'drops', 'latency_us'
+
+# Comandos host -> dispositivo: [cmd, args...]
+CMD_PING_STRUCT = struct.Struct('>BH')
+CMD_SET_SCAN_STRUCT = struct.Struct('>BBH')
+CMD_SET_THRESH_STRUCT = struct.Struct('>BBH')
+CMD_REMAP_STRUCT = struct.Struct('>BBB')
+CMD_GET_STATS_STRUCT = struct.Struct('>B')
+CMD_RESYNC_STRUCT = struct.Struct('>B')
+CMD_ACK_STRUCT = struct.Struct('>BBB')
+CMD_SET_FORMAT_STRUCT = struct.Struct('>BB')
+CMD_HELLO_STRUCT = struct.Struct('>B')
+CMD_GET_LINKS_STRUCT = struct.Struct('>B')
+CMD_KEEPALIVE_STRUCT = struct.Struct('>B')
+CMD_TIME_STRUCT = struct.Struct('>BH')
+CMD_SET_REPORT_STRUCT = struct.Struct('>BB')
+CMD_ECHO_STRUCT = struct.Struct('>BIH')
+
+
+def payload_ping(token):
+    return CMD_PING_STRUCT.pack(CMD_PING, token)
+
+
+def payload_set_scan(target, ms):
+    return CMD_SET_SCAN_STRUCT.pack(CMD_SET_SCAN, target, ms)
+
+
+def payload_set_thresh(ident, value):
+    return CMD_SET_THRESH_STRUCT.pack(CMD_SET_THRESH, ident, value)
+
+
+def payload_remap(index, code):
+    return CMD_REMAP_STRUCT.pack(CMD_REMAP, index, code)
+
+
+def payload_get_stats():
+    return CMD_GET_STATS_STRUCT.pack(CMD_GET_STATS)
+
+
+def payload_resync():
+    return CMD_RESYNC_STRUCT.pack(CMD_RESYNC)
+
+
+def payload_ack(seq, mask):
+    return CMD_ACK_STRUCT.pack(CMD_ACK, seq, mask)
+
+
+def payload_set_format(flags):
+    return CMD_SET_FORMAT_STRUCT.pack(CMD_SET_FORMAT, flags)
+
+
+def payload_hello():
+    return CMD_HELLO_STRUCT.pack(CMD_HELLO)
+
+
+def payload_get_links():
+    return CMD_GET_LINKS_STRUCT.pack(CMD_GET_LINKS)
+
+
+def payload_keepalive():
+    return CMD_KEEPALIVE_STRUCT.pack(CMD_KEEPALIVE)
+
+
+def payload_time(token):
+    return CMD_TIME_STRUCT.pack(CMD_TIME, token)
+
+
+def payload_set_report(ms):
+    return CMD_SET_REPORT_STRUCT.pack(CMD_SET_REPORT, ms)
+
+
+def payload_echo(at_us, packet_us):
+    return CMD_ECHO_STRUCT.pack(CMD_ECHO, at_us, packet_us)
+
+
+# Campos do quadro CODE_STATS, 16 bits cada
+CAMPOS_STATS = ('drops_botao', 'drops_fsr', 'pot_coalescidos', 'tx_overflows', 'tx_pico', 'rx_overflows', 'cmd_ruins', 'baud_x100', 'retransmissoes', 'borda_fila_us', 'borda_linha_us', 'relatorio_periodo_10us', 'relatorio_jitter_10us', 'janela_lote_us', 'rtt_sonda_x100us')
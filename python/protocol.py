@@ -0,0 +1,724 @@
+"""Enquadramento do link serial: COBS + CRC-8, delimitado por 0x00.
+
+Mesmo formato de main/protocol.c. Cada quadro é o payload seguido de um
+CRC-8 (polinômio 0x07, início 0xFF), codificado com COBS e terminado em
+0x00. Como o 0x00 nunca aparece dentro de um quadro, o receptor se
+ressincroniza no próximo delimitador depois de qualquer byte perdido ou corrompido.
+"""
+
+import struct
+from collections import deque
+
+# Códigos, comandos e layouts dos payloads vêm de protocol/schema.json,
+# junto com o firmware (main/proto_frames.h)
+from proto_frames import *  # noqa: F401,F403
+
+DELIMITADOR = 0x00
+
+CODIGOS_CONTROLE = range(0x70, 0x80)
+# Registros do quadro analógico compacto: REC_DELTA, REC_KEY ou REC_RUN | canal
+CODIGOS_REGISTRO = range(0xC0, 0xF0)
+
+# Formatos opcionais que este script sabe decodificar
+FORMATOS_HOST = FMT_COMPACT_ANALOG | FMT_EDGE_TIME
+
+
+def _crc8_byte(crc):
+    for _ in range(8):
+        crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+# Um passo de 8 bits por consulta, em vez de 8 deslocamentos por byte
+_CRC8_TABELA = bytes(_crc8_byte(i) for i in range(256))
+
+
+def crc8(data):
+    # Começa em 0xFF: com 0x00, perder zeros no início do quadro passa no CRC
+    crc = 0xFF
+    for b in data:
+        crc = _CRC8_TABELA[crc ^ b]
+    return crc
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code_idx = 0
+    code = 1
+    for b in data:
+        if b == 0:
+            out[code_idx] = code
+            code_idx = len(out)
+            out.append(0)
+            code = 1
+        else:
+            out.append(b)
+            code += 1
+            if code == 0xFF:
+                out[code_idx] = code
+                code_idx = len(out)
+                out.append(0)
+                code = 1
+    out[code_idx] = code
+    return bytes(out)
+
+
+def cobs_decode_em(origem, inicio, fim, destino):
+    """Decodifica origem[inicio:fim] (um memoryview) em destino, um
+    bytearray com espaço suficiente. Retorna o tamanho, ou -1 se inválido."""
+    o = 0
+    i = inicio
+    while i < fim:
+        code = origem[i]
+        i += 1
+        if code == 0 or i + code - 1 > fim:
+            return -1
+        k = code - 1
+        destino[o:o + k] = origem[i:i + k]
+        o += k
+        i += k
+        if code != 0xFF and i < fim:
+            destino[o] = 0
+            o += 1
+    return o
+
+
+def cobs_decode(data):
+    """Decodifica um bloco COBS (sem o delimitador). Retorna None se inválido."""
+    out = bytearray(len(data))
+    n = cobs_decode_em(memoryview(bytes(data)), 0, len(data), out)
+    return None if n < 0 else bytes(out[:n])
+
+
+def encode_frame(payload):
+    """payload + CRC-8, codificado com COBS e com o delimitador no fim."""
+    payload = bytes(payload)
+    return cobs_encode(payload + bytes([crc8(payload)])) + bytes([DELIMITADOR])
+
+
+# GF(256) com o polinômio 0x11D, o mesmo de main/protocol.c
+GF_EXP = [0] * 510
+GF_LOG = [0] * 256
+_v = 1
+for _i in range(255):
+    GF_EXP[_i] = GF_EXP[_i + 255] = _v
+    GF_LOG[_v] = _i
+    _v = (_v << 1) ^ (0x11D if _v & 0x80 else 0)
+
+
+def fec_paridade(bloco, n=None):
+    """P = soma de B[i], Q = soma de x^i * B[i] (Reed-Solomon com 2 símbolos),
+    sobre os n primeiros bytes do bloco."""
+    p = q = 0
+    for i in range(len(bloco) - 1 if n is None else n - 1, -1, -1):
+        b = bloco[i]
+        p ^= b
+        q = ((q << 1) ^ (0x11D if q & 0x80 else 0)) ^ b
+    return p, q
+
+
+_paridade = bytearray(3)
+
+
+def fec_localizar(quadro, n):
+    """Separa o bloco COBS da paridade nos n primeiros bytes do quadro
+    (um memoryview), sem copiar nem alterar nada.
+
+    Retorna (tamanho do bloco, posição, erro): o byte na posição, com
+    xor erro, é a correção; erro 0 não corrige nada. (-1, 0, 0) se não
+    dá para corrigir.
+    """
+    if n < 4:
+        return -1, 0, 0
+    if cobs_decode_em(quadro, n - 3, n, _paridade) != 2:
+        # O erro caiu na paridade, que só serve para corrigir
+        return n - 3, 0, 0
+    p, q = fec_paridade(quadro, n - 3)
+    s0, s1 = p ^ _paridade[0], q ^ _paridade[1]
+    if s0 == 0 or s1 == 0:
+        # Sem erro no bloco (ou só na paridade)
+        return n - 3, 0, 0
+    posicao = (GF_LOG[s1] - GF_LOG[s0]) % 255
+    if posicao >= n - 3:
+        return -1, 0, 0
+    return n - 3, posicao, s0
+
+
+def fec_corrigir(quadro):
+    """Separa o bloco COBS da paridade e corrige até um byte errado.
+
+    Retorna (bloco, corrigido) ou (None, False) se não dá para corrigir.
+    """
+    bloco = bytearray(quadro)
+    n, posicao, erro = fec_localizar(memoryview(bloco), len(bloco))
+    if n < 0:
+        return None, False
+    bloco[posicao] ^= erro
+    return bytes(bloco[:n]), erro != 0
+
+
+def encode_frame_fec(payload):
+    """encode_frame com a paridade FEC antes do delimitador."""
+    bloco = encode_frame(payload)[:-1]
+    return bloco + cobs_encode(bytes(fec_paridade(bloco))) + bytes([DELIMITADOR])
+
+
+def cmd_ping(token):
+    return encode_frame(payload_ping(token))
+
+
+def cmd_set_scan(alvo, ms):
+    return encode_frame(payload_set_scan(alvo, ms))
+
+
+def cmd_set_threshold(ident, valor):
+    return encode_frame(payload_set_thresh(ident, valor))
+
+
+def cmd_remap(indice_botao, codigo):
+    return encode_frame(payload_remap(indice_botao, codigo))
+
+
+def cmd_get_stats():
+    return encode_frame(payload_get_stats())
+
+
+def cmd_resync():
+    return encode_frame(payload_resync())
+
+
+def cmd_set_format(flags):
+    return encode_frame(payload_set_format(flags))
+
+
+def cmd_hello():
+    return encode_frame(payload_hello())
+
+
+def parse_hello(payload):
+    """Converte um quadro CODE_HELLO completo em dicionário."""
+    if len(payload) < HELLO.size:
+        return None
+    (_, _, versao, formatos, canais, tick_ms, heartbeat_10ms,
+     fsr_primeiro, fsr_niveis, n_botoes) = HELLO.unpack_from(payload)
+    return {
+        'versao': versao,
+        'formatos': formatos,
+        'canais_analogicos': [c for c in range(8) if canais & (1 << c)],
+        'tick_ms': tick_ms,
+        'heartbeat_ms': heartbeat_10ms * 10,
+        'fsr_codigos': list(range(fsr_primeiro, fsr_primeiro + fsr_niveis)),
+        'botoes': list(payload[HELLO.size:HELLO.size + n_botoes]),
+    }
+
+
+def cmd_keepalive():
+    return encode_frame(payload_keepalive())
+
+
+def cmd_time(token):
+    return encode_frame(payload_time(token))
+
+
+def cmd_set_report(ms):
+    """Relatórios de estado a cada ms (2 a 100); 0 volta para os eventos."""
+    return encode_frame(payload_set_report(ms))
+
+
+def cmd_echo(at_us, pacote_us):
+    """Devolve uma sonda CODE_PROBE, com o intervalo entre pacotes de rádio visto pelo host."""
+    return encode_frame(payload_echo(at_us, min(int(pacote_us), 0xFFFF)))
+
+
+def cmd_get_links():
+    return encode_frame(payload_get_links())
+
+
+NOMES_LINK = {LINK_HC06: 'HC-06', LINK_CDC: 'USB'}
+
+
+def parse_links(payload):
+    """Converte um quadro CODE_LINKS completo em lista de dicionários, um por link."""
+    if len(payload) < 3:
+        return None
+    n = payload[2]
+    if len(payload) < 3 + n * LINK.size:
+        return None
+    links = []
+    for i in range(n):
+        ident, pronto, pendente, drops, latencia_us = LINK.unpack_from(payload, 3 + i * LINK.size)
+        links.append({'nome': NOMES_LINK.get(ident, str(ident)), 'pronto': bool(pronto),
+                      'pendente': pendente, 'drops': drops, 'latencia_us': latencia_us})
+    return links
+
+
+def escolher_formato(capacidades, extras=0):
+    """Melhor formato suportado pelos dois lados; 0 é o formato original.
+
+    extras liga formatos que custam banda e só valem a pena em alguns
+    casos, como FMT_FEC.
+    """
+    if capacidades is None or capacidades['versao'] != VERSAO_PROTOCOLO:
+        return 0
+    return capacidades['formatos'] & (FORMATOS_HOST | extras)
+
+
+def cmd_ack(seq, mascara):
+    """ACK seletivo: confirma seq e, para cada bit i de mascara, seq - 1 - i."""
+    return encode_frame(payload_ack(seq, mascara))
+
+
+def eh_borda(codigo):
+    """Bordas (botões e FSR) são confirmadas; o eixo analógico não."""
+    return 0x01 <= (codigo & 0x7F) <= 0x0F
+
+
+def parse_state(payload):
+    """Converte um quadro CODE_STATE completo em (pressionados, pot).
+
+    pressionados é o conjunto de códigos de borda mantidos, incluindo o
+    nível atual do FSR.
+    """
+    _, _, mascara, _, pot = STATE.unpack_from(payload)
+    pressionados = {c for c in range(1, 16) if mascara & (1 << c)}
+    return pressionados, pot
+
+
+def parse_stats(payload):
+    """Converte um quadro CODE_STATS completo em dicionário."""
+    n = min((len(payload) - 2) // 2, len(CAMPOS_STATS))
+    valores = struct.unpack_from(f'>{n}H', payload, 2)
+    return dict(zip(CAMPOS_STATS, valores))
+
+
+def zigzag_decode(n):
+    return (n >> 1) ^ -(n & 1)
+
+
+def ler_varint(data, i):
+    """Lê um varint (7 bits por byte, menos significativo primeiro) a partir de i."""
+    n, desloc = 0, 0
+    while i < len(data):
+        b = data[i]
+        i += 1
+        n |= (b & 0x7F) << desloc
+        desloc += 7
+        if not b & 0x80:
+            break
+    return n, i
+
+
+class AnalogDecoder:
+    """Decodifica os registros dos quadros analógicos compactos.
+
+    Um delta só vale se o host conhece o valor anterior do canal, então
+    deltas recebidos antes de um quadro-chave (ou depois de uma perda) são
+    descartados.
+    """
+
+    def __init__(self):
+        self.ultimo = {}
+        self.atualizacoes = 0
+        self.rejeitados = 0
+        self.bytes_no_fio = 0
+
+    def invalidar(self):
+        """Esquece os valores base, por exemplo depois de um quadro perdido."""
+        self.ultimo.clear()
+
+    def feed(self, data):
+        """Recebe o payload sem o seq e retorna a lista de (canal, valor)."""
+        valores = []
+        # payload + seq + CRC + byte de código COBS + delimitador
+        self.bytes_no_fio += len(data) + 4
+        i = 0
+        while i < len(data):
+            tipo = data[i] & 0xF0
+            canal = data[i] & 0x0F
+            i += 1
+            if tipo == REC_KEY:
+                if i + 2 > len(data):
+                    break
+                valor = int.from_bytes(data[i:i + 2], 'big', signed=True)
+                i += 2
+            elif tipo == REC_DELTA:
+                n, i = ler_varint(data, i)
+                if canal not in self.ultimo:
+                    self.rejeitados += 1
+                    continue
+                valor = self.ultimo[canal] + zigzag_decode(n)
+            elif tipo == REC_RUN:
+                # Várias atualizações seguidas do mesmo canal, um delta cada
+                if i >= len(data):
+                    break
+                quantas = data[i]
+                i += 1
+                for _ in range(quantas):
+                    n, i = ler_varint(data, i)
+                    if canal not in self.ultimo:
+                        self.rejeitados += 1
+                        continue
+                    self.ultimo[canal] += zigzag_decode(n)
+                    self.atualizacoes += 1
+                    valores.append((canal, self.ultimo[canal]))
+                continue
+            else:
+                break
+            self.ultimo[canal] = valor
+            self.atualizacoes += 1
+            valores.append((canal, valor))
+        return valores
+
+    def resumo(self):
+        if not self.atualizacoes:
+            return ""
+        media = self.bytes_no_fio / self.atualizacoes
+        # No formato original cada atualização é um quadro de 7 bytes
+        economia = 100 * (1 - media / 7)
+        return (f"pot {media:.1f} B/atualização (economia de {economia:.0f}%), "
+                f"{self.rejeitados} deltas sem base")
+
+
+class RelogioDispositivo:
+    """Relaciona o time_us_32() do dispositivo com o monotonic() do host.
+
+    Cada troca CMD_TIME/CODE_TIME dá quatro instantes, como no NTP: t1 e
+    t4 no host (envio e chegada), t2 e t3 no dispositivo (leitura do
+    pedido e saída da resposta). O offset de cada amostra erra pela metade
+    da assimetria entre ida e volta, então só as amostras de menor atraso
+    entram na reta offset x tempo, que dá também a deriva do cristal.
+    """
+
+    JANELA = 32
+    # Abaixo disso a deriva medida é mais ruído que cristal
+    INTERVALO_MIN_DERIVA = 5.0  # segundos
+
+    def __init__(self):
+        self.amostras = deque(maxlen=self.JANELA)  # (t_host, offset, atraso)
+        self.ref_bruto = None
+        self.ref = 0.0
+        self.offset = None  # dispositivo - host em t_ref, segundos
+        self.deriva = 0.0
+        self.t_ref = 0.0
+        self.incerteza = None
+
+    def _desenrolar(self, us):
+        """Segundos do dispositivo, escolhendo a volta do contador de 32 bits
+        (~71 min) mais próxima da última amostra."""
+        if self.ref_bruto is None:
+            return us / 1e6
+        d = ((us - self.ref_bruto + (1 << 31)) & 0xFFFFFFFF) - (1 << 31)
+        return self.ref + d / 1e6
+
+    def adicionar(self, t1, t2_us, t3_us, t4):
+        t2 = self._desenrolar(t2_us)
+        t3 = t2 + ((t3_us - t2_us) & 0xFFFFFFFF) / 1e6
+        self.ref_bruto, self.ref = t3_us, t3
+
+        offset = ((t2 - t1) + (t3 - t4)) / 2
+        atraso = (t4 - t1) - (t3 - t2)
+        self.amostras.append(((t1 + t4) / 2, offset, atraso))
+
+        # Metade das amostras, as de menor atraso
+        boas = sorted(self.amostras, key=lambda a: a[2])[:max(1, len(self.amostras) // 2)]
+        self.incerteza = boas[0][2] / 2
+        t_medio = sum(a[0] for a in boas) / len(boas)
+        o_medio = sum(a[1] for a in boas) / len(boas)
+        var_t = sum((a[0] - t_medio) ** 2 for a in boas)
+        span = max(a[0] for a in boas) - min(a[0] for a in boas)
+        if len(boas) >= 4 and span >= self.INTERVALO_MIN_DERIVA:
+            self.deriva = sum((a[0] - t_medio) * (a[1] - o_medio) for a in boas) / var_t
+            self.t_ref, self.offset = t_medio, o_medio
+        else:
+            self.deriva = 0.0
+            self.t_ref, self.offset = boas[0][0], boas[0][1]
+
+    def sincronizado(self):
+        return self.offset is not None
+
+    def para_host(self, us):
+        """Instante do dispositivo (time_us_32) no relógio monotonic() do host."""
+        dev = self._desenrolar(us)
+        # dev = h + offset + deriva * (h - t_ref)
+        return (dev - self.offset + self.deriva * self.t_ref) / (1 + self.deriva)
+
+    def resumo(self):
+        if not self.sincronizado():
+            return ""
+        return (f"relógio: deriva {self.deriva * 1e6:+.0f} ppm, "
+                f"incerteza ±{self.incerteza * 1000:.1f} ms")
+
+
+class Pacotizacao:
+    """Estima de quanto em quanto tempo o rádio entrega um pacote.
+
+    O HC-06 junta os bytes em pacotes de rádio, então eles chegam ao host
+    em rajadas. Leituras separadas por mais de LACUNA_MIN são rajadas
+    diferentes; com tráfego contínuo, o intervalo entre rajadas se
+    concentra em múltiplos do intervalo de conexão, e o quartil inferior
+    fica perto do próprio intervalo.
+    """
+
+    LACUNA_MIN = 0.001  # segundos; abaixo disso é o mesmo pacote
+    LACUNA_MAX = 0.1  # acima disso o link estava parado, não conta
+    JANELA = 64
+
+    def __init__(self):
+        self.ultima = None
+        self.lacunas = deque(maxlen=self.JANELA)
+
+    def chegada(self, t):
+        """Registra o instante de uma leitura que trouxe bytes."""
+        if self.ultima is not None:
+            lacuna = t - self.ultima
+            if self.LACUNA_MIN <= lacuna <= self.LACUNA_MAX:
+                self.lacunas.append(lacuna)
+        self.ultima = t
+
+    def intervalo_us(self):
+        if len(self.lacunas) < 8:
+            return 0
+        return sorted(self.lacunas)[len(self.lacunas) // 4] * 1e6
+
+
+class LatenciaBordas:
+    """Divide a latência de cada borda em fila no dispositivo, link e host."""
+
+    ETAPAS = ('fila', 'link', 'host')
+
+    def __init__(self):
+        self.zerar()
+
+    def zerar(self):
+        self.n = 0
+        self.soma = dict.fromkeys(self.ETAPAS, 0.0)
+        self.pior = dict.fromkeys(self.ETAPAS, 0.0)
+
+    def registrar(self, **etapas):
+        self.n += 1
+        for nome, valor in etapas.items():
+            self.soma[nome] += valor
+            self.pior[nome] = max(self.pior[nome], valor)
+
+    def resumo(self):
+        """Médias e piores casos desde o último resumo, em ms."""
+        if not self.n:
+            return ""
+        partes = [f"{nome} {1000 * self.soma[nome] / self.n:.1f}/{1000 * self.pior[nome]:.1f}"
+                  for nome in self.ETAPAS]
+        self.zerar()
+        return "bordas (média/pior ms): " + ", ".join(partes)
+
+
+class FrameDecoder:
+    """Separa os quadros de um fluxo de bytes e valida o CRC.
+
+    Bytes recebidos antes do primeiro delimitador são descartados sem contar
+    como erro, já que a conexão pode começar no meio de um quadro.
+
+    O quadro é montado, corrigido e decodificado em buffers alocados uma
+    vez; a única cópia por quadro é o payload entregue a quem chamou.
+    """
+
+    MAX_QUADRO = 64
+
+    def __init__(self):
+        # Com FMT_FEC ligado, cada quadro traz 3 bytes de paridade
+        self.fec = False
+        self.quadros_corrigidos = 0
+        self.buffer = bytearray(self.MAX_QUADRO)
+        self.tamanho = 0
+        self._quadro = memoryview(self.buffer)
+        self._raw = bytearray(self.MAX_QUADRO)
+        self._raw_mv = memoryview(self._raw)
+        self.sincronizado = False
+        self.estourou = False
+        self.quadros_ok = 0
+        self.quadros_ruins = 0
+        self.bytes_recebidos = 0
+
+    def feed(self, data):
+        """Recebe bytes crus e retorna a lista de payloads válidos completos."""
+        payloads = []
+        n = len(data)
+        self.bytes_recebidos += n
+        dados = memoryview(data)
+        i = 0
+        while i < n:
+            j = data.find(DELIMITADOR, i)
+            fim = n if j < 0 else j
+            k = fim - i
+            if k:
+                if self.tamanho + k <= self.MAX_QUADRO:
+                    self.buffer[self.tamanho:self.tamanho + k] = dados[i:fim]
+                    self.tamanho += k
+                else:
+                    # Quadro grande demais: só pode ser lixo, espera o próximo 0x00
+                    self.estourou = True
+            if j < 0:
+                break
+            i = j + 1
+            self._fim_do_quadro(payloads)
+        return payloads
+
+    def _fim_do_quadro(self, payloads):
+        tamanho = self.tamanho
+        self.tamanho = 0
+        if self.estourou:
+            self.estourou = False
+            if self.sincronizado:
+                self.quadros_ruins += 1
+            self.sincronizado = True
+            return
+        if not self.sincronizado:
+            self.sincronizado = True
+            return
+        if not tamanho:
+            return
+
+        corrigido = False
+        if self.fec:
+            raw = -1
+            bloco, posicao, erro = fec_localizar(self._quadro, tamanho)
+            if bloco >= 0:
+                # Corrige no lugar e desfaz depois: a tentativa sem
+                # paridade abaixo precisa do quadro como chegou
+                self.buffer[posicao] ^= erro
+                raw = self._validar(bloco)
+                self.buffer[posicao] ^= erro
+                corrigido = raw >= 0 and erro != 0
+            if raw < 0:
+                # Um dispositivo que reiniciou volta ao formato original
+                # e anuncia isso com um HELLO. Só esse quadro é aceito
+                # sem paridade: aceitar qualquer um daria a um quadro
+                # com erros uma segunda chance de passar no CRC.
+                raw = self._validar(tamanho)
+                if raw >= 0 and not self._e_hello(raw):
+                    raw = -1
+        else:
+            raw = self._validar(tamanho)
+        if raw < 0:
+            self.quadros_ruins += 1
+            return
+        if corrigido:
+            self.quadros_corrigidos += 1
+
+        self.quadros_ok += 1
+        payloads.append(bytes(self._raw_mv[:raw - 1]))
+
+    def _e_hello(self, n):
+        # _raw = [seq, código, ...] + CRC
+        return n > HELLO.size and self._raw[1] == CODE_HELLO
+
+    def _validar(self, n):
+        """Decodifica os n primeiros bytes do quadro em _raw. Retorna o
+        tamanho de payload + CRC, ou -1 se o COBS ou o CRC não batem."""
+        raw = cobs_decode_em(self._quadro, 0, n, self._raw)
+        if raw < 2 or crc8(self._raw_mv[:raw - 1]) != self._raw[raw - 1]:
+            return -1
+        return raw
+
+
+class SequenceTracker:
+    """Contabiliza perdas a partir do número de sequência (8 bits) de cada quadro."""
+
+    # Atrasos maiores que isso são tratados como um salto para frente
+    JANELA_REORDEM = 64
+
+    def __init__(self):
+        self.esperado = None
+        # Bit n: o quadro com seq n já chegou (na volta atual do contador)
+        self.vistos = 0
+        self.recebidos = 0
+        self.perdidos = 0
+        self.duplicados = 0
+        self.fora_de_ordem = 0
+
+    def update(self, seq):
+        """Retorna False se o quadro é duplicado e deve ser ignorado."""
+        self.recebidos += 1
+        if self.esperado is None:
+            self.esperado = (seq + 1) & 0xFF
+            self.vistos = 1 << seq
+            return True
+
+        d = (seq - self.esperado) & 0xFF
+        if d >= 0x100 - self.JANELA_REORDEM:
+            if self.vistos & (1 << seq):
+                # Retransmissão de algo que já chegou (o ACK se perdeu)
+                self.duplicados += 1
+                return False
+            # Chegou depois de um quadro mais novo: já tinha sido contado como perdido
+            self.fora_de_ordem += 1
+            self.perdidos -= 1
+        else:
+            # Os seqs pulados ainda não chegaram nesta volta
+            for s in range(self.esperado, self.esperado + d):
+                self.vistos &= ~(1 << (s & 0xFF))
+            self.perdidos += d
+            self.esperado = (seq + 1) & 0xFF
+        self.vistos |= 1 << seq
+        return True
+
+    def mascara_ack(self, seq):
+        """Bits dos 8 quadros anteriores a seq que já chegaram."""
+        mascara = 0
+        for i in range(8):
+            if self.vistos & (1 << ((seq - 1 - i) & 0xFF)):
+                mascara |= 1 << i
+        return mascara
+
+    def resync(self):
+        """Esquece a última sequência, por exemplo depois de o link cair."""
+        self.esperado = None
+
+    def resumo(self, decoder=None):
+        texto = (f"rx {self.recebidos} | perdidos {self.perdidos} | "
+                 f"dup {self.duplicados} | fora de ordem {self.fora_de_ordem}")
+        if decoder is not None:
+            texto += f" | CRC/COBS ruins {decoder.quadros_ruins}"
+            if decoder.fec:
+                texto += f" | corrigidos {decoder.quadros_corrigidos}"
+        return texto
+
+
+class OrdemBordas:
+    """Última borda aplicada por código, para descartar reenvios atrasados.
+
+    Um reenvio pode chegar depois de uma borda mais nova do mesmo código, ou
+    de um quadro de estado que já a inclui. Aplicá-lo deixaria a tecla
+    presa (ou solta) até o próximo quadro de estado.
+    """
+
+    # Mais velho que isso o seq de 8 bits fica ambíguo: o registro é esquecido
+    JANELA = SequenceTracker.JANELA_REORDEM
+
+    def __init__(self):
+        self.ultimo = {}
+        self.recente = None
+
+    def avancar(self, seq):
+        """Chamado a cada quadro aceito: esquece registros fora da janela."""
+        # Mesmo critério do SequenceTracker para separar atraso de salto
+        if self.recente is None or (seq - self.recente) & 0xFF < 0x100 - self.JANELA:
+            self.recente = seq
+        for codigo, s in list(self.ultimo.items()):
+            if (self.recente - s) & 0xFF >= self.JANELA:
+                del self.ultimo[codigo]
+
+    def aceitar(self, codigo, seq):
+        """False se o código já tem uma borda (ou estado) mais nova que seq."""
+        ultimo = self.ultimo.get(codigo)
+        if ultimo is not None and 0 <= (ultimo - seq) & 0xFF < self.JANELA:
+            return False
+        self.ultimo[codigo] = seq
+        return True
+
+    def estado(self, seq, codigos):
+        """Registra um quadro de estado e retorna os códigos em que ele vale."""
+        return {c for c in codigos if self.aceitar(c, seq)}
+
+    def esquecer(self):
+        """O dispositivo pode ter reiniciado a contagem de seq."""
+        self.ultimo.clear()
+        self.recente = None
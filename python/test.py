@@ -4,13 +4,20 @@ import serial
 import time
 import random
 
+import protocol
+
 ser = serial.Serial('/dev/pts/0', 115200)
+seq = 0
 
-def send_movement(axis, value):
-    """Send a movement command in the specified format: axis (8 bits), value (8 bits), end-of-package indicator (8 bits)."""
-    msb = ((value & 0xFF00) >> 8)
-    lsb = value & 0x0FF
-    data = bytearray([axis, lsb, msb, 0xFF])  # 0xFF for -1 as end-of-package
+def send_movement(axis, value, drop=False):
+    """Send a movement frame: seq (8 bits), axis (8 bits), value (16 bits, big endian), CRC-8, COBS framed."""
+    global seq
+    data = protocol.encode_frame(protocol.EVENT.pack(seq, axis, value))
+    seq = (seq + 1) & 0xFF
+    if drop:
+        # Fault injection: lose one random byte, the host must resync on the next frame
+        i = random.randrange(len(data))
+        data = data[:i] + data[i + 1:]
     ser.write(data)
 
 try:
@@ -20,7 +27,7 @@ try:
         axis = 0
         value = random.randint(-127, 127)  # Random movement value
         value = int(input())
-        send_movement(axis, value)
+        send_movement(axis, value, drop=random.random() < 0.1)
         time.sleep(1)  # Adjust sleep time as needed
 except KeyboardInterrupt:
     print("Program terminated by user")
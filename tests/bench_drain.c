@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "check.h"
+#include "event_bus.h"
+#include "hc06_task.h"
+#include "protocol.h"
+#include "settings.h"
+#include "transport.h"
+
+// The real hc06C_task drain path on the host FreeRTOS port: a task posts
+// a burst of edges while hc06C_task cannot run, then blocks. Each burst
+// must leave in a single write to the link, and the host time from the
+// last post to the last frame gives the drain rate. Only the ratios carry
+// over to the RP2040; there the UART (115200 baud) is the limit. Before
+// the batched drain, one event left per 10 ms loop: 100 events/s.
+
+#define ROUNDS 500
+#define EDGE_CAPACITY 10  // EDGE_QUEUE_LEN in hc06_task.c
+#define BAUD 115200
+
+settings_t settings = {.heartbeat_ms = 250};
+
+// hc06_task announces HELLO through command.c, which is not part of this
+// benchmark
+void command_announce(void) {}
+
+static const int bursts[] = {1, 4, 8, EDGE_CAPACITY};
+
+static TaskHandle_t bench_handle;
+static volatile int edges_seen, edges_expected;
+static int edge_writes;
+static size_t edge_bytes;
+static double done_ns;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void sink_start(void) {}
+
+static bool sink_ready(void) {
+    return true;
+}
+
+static size_t sink_room(transport_lane_t lane) {
+    (void)lane;
+    return 4096;
+}
+
+static size_t sink_pending(transport_lane_t lane) {
+    (void)lane;
+    return 0;
+}
+
+// Counts the edge frames in each write, as the host would decode them
+static bool sink_write(transport_lane_t lane, const uint8_t *data, size_t len) {
+    uint8_t payload[PROTO_MAX_PAYLOAD];
+    size_t start = 0;
+
+    if (lane != TRANSPORT_LANE_EDGE)
+        return true;
+    edge_writes++;
+    edge_bytes += len;
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] != 0)
+            continue;
+        size_t n = proto_decode_frame(&data[start], i - start, payload);
+        if (n >= 2 && (payload[1] & 0x7F) >= 1 && (payload[1] & 0x7F) <= 15)
+            edges_seen++;
+        start = i + 1;
+    }
+    if (edges_seen >= edges_expected) {
+        done_ns = now_ns();
+        xTaskNotifyGive(bench_handle);
+    }
+    return true;
+}
+
+static transport_t sink = {.start = sink_start, .ready = sink_ready, .room = sink_room,
+                           .write = sink_write, .pending = sink_pending};
+
+static void bench_task(void *p) {
+    (void)p;
+    // Let hc06C_task send its first state frame
+    vTaskDelay(2);
+
+    printf("burst drain through hc06C_task:\n");
+    for (size_t b = 0; b < sizeof(bursts) / sizeof(bursts[0]); b++) {
+        int n = bursts[b];
+        double drain_ns = 0;
+        int writes = 0;
+        size_t bytes = 0;
+
+        for (int r = 0; r < ROUNDS; r++) {
+            edges_seen = 0;
+            edges_expected = n;
+            edge_writes = 0;
+            edge_bytes = 0;
+            for (int k = 0; k < n; k++) {
+                event_t ev = {.source = EV_SRC_BUTTON, .code = (uint8_t)(1 + k % 12),
+                              .value = (int16_t)(r & 1)};
+                bus_post(&ev);
+            }
+            double posted = now_ns();
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            drain_ns += done_ns - posted;
+            writes += edge_writes;
+            bytes += edge_bytes;
+            CHECK(edges_seen == n);
+        }
+
+        double per_burst_us = drain_ns / ROUNDS / 1000;
+        double wire_ms = (double)bytes / ROUNDS * 10 * 1000 / BAUD;
+        printf("  %2d edge(s): %.2f write(s)/burst, %6.1f us host drain, "
+               "%5.0f k events/s, %.2f ms on the wire at %d baud\n",
+               n, (double)writes / ROUNDS, per_burst_us, n / per_burst_us * 1000,
+               wire_ms, BAUD);
+        // The whole burst goes out in one wakeup and one transfer
+        CHECK(writes == ROUNDS);
+    }
+    vTaskEndScheduler();
+}
+
+int main(void) {
+    hc06_task_init();
+    transport_register(&sink);
+
+    xTaskCreate(hc06C_task, "HC06", configMINIMAL_STACK_SIZE * 4, NULL, 2, NULL);
+    xTaskCreate(bench_task, "BENCH", configMINIMAL_STACK_SIZE * 4, NULL, 3, &bench_handle);
+    vTaskStartScheduler();
+    return check_result("bench_drain");
+}
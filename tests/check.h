@@ -0,0 +1,39 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Minimal assertions for the host tests: a failed CHECK is reported and
+// counted, and main() returns check_result() so ctest sees the failure.
+
+static int check_failures = 0;
+
+#define CHECK(cond)                                                          \
+    do {                                                                     \
+        if (!(cond)) {                                                       \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            check_failures++;                                                \
+        }                                                                    \
+    } while (0)
+
+// Fixed seed so a failing fuzz case can be reproduced
+static uint32_t check_rng_state = 0x12345678;
+
+static inline uint32_t check_rand(void) {
+    uint32_t x = check_rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return check_rng_state = x;
+}
+
+static inline int check_result(const char *name) {
+    if (check_failures)
+        fprintf(stderr, "%s: %d check(s) failed\n", name, check_failures);
+    else
+        printf("%s: ok\n", name);
+    return check_failures != 0;
+}
+
+#endif
@@ -0,0 +1,148 @@
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/irq.h"
+#include "hardware/uart.h"
+
+#define FAKE_IRQ_COUNT 32
+// uart_tx writes dr directly; the value is picked up into the FIFO the
+// next time the driver asks whether there is room
+#define DR_EMPTY 0x100
+
+static uint64_t now_us = 0;
+
+uint32_t time_us_32(void) {
+    return (uint32_t)now_us;
+}
+
+uint64_t time_us_64(void) {
+    return now_us;
+}
+
+void fake_advance_us(uint32_t us) {
+    now_us += us;
+}
+
+static alarm_id_t next_alarm = 0;
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    (void)us;
+    (void)callback;
+    (void)user_data;
+    (void)fire_if_past;
+    return ++next_alarm;
+}
+
+bool cancel_alarm(alarm_id_t id) {
+    return id > 0 && id <= next_alarm;
+}
+
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data,
+                            repeating_timer_t *out) {
+    out->delay_us = delay_us;
+    out->callback = callback;
+    out->user_data = user_data;
+    return true;
+}
+
+bool cancel_repeating_timer(repeating_timer_t *timer) {
+    timer->callback = NULL;
+    return true;
+}
+
+static irq_handler_t handlers[FAKE_IRQ_COUNT];
+static bool enabled[FAKE_IRQ_COUNT];
+
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order) {
+    (void)order;
+    handlers[num] = handler;
+}
+
+void irq_set_enabled(uint num, bool en) {
+    enabled[num] = en;
+}
+
+void fake_irq_fire(uint num) {
+    if (enabled[num] && handlers[num] != NULL)
+        handlers[num]();
+}
+
+struct uart_inst {
+    uart_hw_t hw;
+    uint8_t fifo[UART_FIFO_DEPTH];
+    size_t level;
+};
+
+static struct uart_inst uarts[2] = {
+    {.hw = {.dr = DR_EMPTY, .fr = UART_UARTFR_TXFE_BITS}},
+    {.hw = {.dr = DR_EMPTY, .fr = UART_UARTFR_TXFE_BITS}},
+};
+uart_inst_t *const uart0 = &uarts[0];
+uart_inst_t *const uart1 = &uarts[1];
+
+static void update_flags(uart_inst_t *u) {
+    uint32_t fr = 0;
+    if (u->level == 0)
+        fr |= UART_UARTFR_TXFE_BITS;
+    else
+        fr |= UART_UARTFR_BUSY_BITS;
+    if (u->level == UART_FIFO_DEPTH)
+        fr |= UART_UARTFR_TXFF_BITS;
+    u->hw.fr = fr;
+}
+
+static void latch(uart_inst_t *u) {
+    if (u->hw.dr == DR_EMPTY)
+        return;
+    if (u->level < UART_FIFO_DEPTH)
+        u->fifo[u->level++] = (uint8_t)u->hw.dr;
+    u->hw.dr = DR_EMPTY;
+    update_flags(u);
+}
+
+uart_hw_t *uart_get_hw(uart_inst_t *u) {
+    return &u->hw;
+}
+
+uint uart_get_index(uart_inst_t *u) {
+    return u == uart0 ? 0 : 1;
+}
+
+bool uart_is_writable(uart_inst_t *u) {
+    latch(u);
+    return u->level < UART_FIFO_DEPTH;
+}
+
+void hw_set_bits(volatile uint32_t *reg, uint32_t mask) {
+    *reg |= mask;
+}
+
+void hw_clear_bits(volatile uint32_t *reg, uint32_t mask) {
+    *reg &= ~mask;
+}
+
+void hw_write_masked(volatile uint32_t *reg, uint32_t values, uint32_t mask) {
+    *reg = (*reg & ~mask) | (values & mask);
+}
+
+size_t fake_uart_tx_level(uart_inst_t *u) {
+    latch(u);
+    return u->level;
+}
+
+size_t fake_uart_shift(uart_inst_t *u, uint8_t *out, size_t max) {
+    latch(u);
+    size_t n = u->level < max ? u->level : max;
+    memcpy(out, u->fifo, n);
+    memmove(u->fifo, u->fifo + n, u->level - n);
+    u->level -= n;
+    update_flags(u);
+
+    // TXIFLSEL 0 means "at or below 1/8 full"
+    if (u->level <= UART_FIFO_DEPTH / 8 && (u->hw.imsc & UART_UARTIMSC_TXIM_BITS)) {
+        u->hw.mis = UART_UARTIMSC_TXIM_BITS;
+        fake_irq_fire(uart_get_index(u) == 0 ? UART0_IRQ : UART1_IRQ);
+        u->hw.mis = 0;
+        latch(u);
+    }
+    return n;
+}
@@ -0,0 +1,85 @@
+#include <pthread.h>
+#include <string.h>
+#include "tusb.h"
+
+typedef struct {
+    uint8_t data[CFG_TUD_CDC_TX_BUFSIZE];
+    size_t size, head, tail;  // head - tail bytes stored
+} fifo_t;
+
+static fifo_t tx = {.size = CFG_TUD_CDC_TX_BUFSIZE};
+static fifo_t rx = {.size = CFG_TUD_CDC_RX_BUFSIZE};
+static bool cdc_connected = false;
+static pthread_t owner;
+static bool owner_set = false;
+static uint32_t foreign_calls = 0;
+
+static void note_call(void) {
+    if (owner_set && !pthread_equal(owner, pthread_self()))
+        foreign_calls++;
+}
+
+static size_t fifo_put(fifo_t *f, const uint8_t *data, size_t len) {
+    size_t n = 0;
+    while (n < len && f->head - f->tail < f->size)
+        f->data[f->head++ % f->size] = data[n++];
+    return n;
+}
+
+static size_t fifo_get(fifo_t *f, uint8_t *data, size_t len) {
+    size_t n = 0;
+    while (n < len && f->tail != f->head)
+        data[n++] = f->data[f->tail++ % f->size];
+    return n;
+}
+
+bool tud_cdc_connected(void) {
+    note_call();
+    return cdc_connected;
+}
+
+uint32_t tud_cdc_available(void) {
+    note_call();
+    return rx.head - rx.tail;
+}
+
+uint32_t tud_cdc_read(void *buffer, uint32_t bufsize) {
+    note_call();
+    return fifo_get(&rx, buffer, bufsize);
+}
+
+uint32_t tud_cdc_write_available(void) {
+    note_call();
+    return tx.size - (tx.head - tx.tail);
+}
+
+uint32_t tud_cdc_write(const void *buffer, uint32_t bufsize) {
+    note_call();
+    return fifo_put(&tx, buffer, bufsize);
+}
+
+uint32_t tud_cdc_write_flush(void) {
+    note_call();
+    return 0;
+}
+
+void fake_cdc_set_connected(bool connected) {
+    cdc_connected = connected;
+}
+
+size_t fake_cdc_host_read(uint8_t *data, size_t len) {
+    return fifo_get(&tx, data, len);
+}
+
+size_t fake_cdc_host_write(const uint8_t *data, size_t len) {
+    return fifo_put(&rx, data, len);
+}
+
+void fake_tusb_set_owner(void) {
+    owner = pthread_self();
+    owner_set = true;
+}
+
+uint32_t fake_tusb_foreign_calls(void) {
+    return foreign_calls;
+}
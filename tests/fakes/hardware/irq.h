@@ -0,0 +1,18 @@
+#ifndef FAKE_HARDWARE_IRQ_H
+#define FAKE_HARDWARE_IRQ_H
+
+#include "pico/stdlib.h"
+
+#define UART0_IRQ 20
+#define UART1_IRQ 21
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY 0x80
+
+typedef void (*irq_handler_t)(void);
+
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order);
+void irq_set_enabled(uint num, bool enabled);
+
+// Runs the handler registered for num, if its line is enabled
+void fake_irq_fire(uint num);
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef FAKE_HARDWARE_UART_H
+#define FAKE_HARDWARE_UART_H
+
+// A UART whose TX FIFO only empties when the test says the bytes went out
+// on the wire (fake_uart_shift).
+
+#include "pico/stdlib.h"
+
+typedef struct {
+    volatile uint32_t dr, fr, ifls, imsc, mis;
+} uart_hw_t;
+
+typedef struct uart_inst uart_inst_t;
+extern uart_inst_t *const uart0;
+extern uart_inst_t *const uart1;
+
+#define UART_FIFO_DEPTH             32
+#define UART_UARTFR_BUSY_BITS       0x08
+#define UART_UARTFR_TXFF_BITS       0x20
+#define UART_UARTFR_TXFE_BITS       0x80
+#define UART_UARTIMSC_TXIM_BITS     0x20
+#define UART_UARTIFLS_TXIFLSEL_LSB  0
+#define UART_UARTIFLS_TXIFLSEL_BITS 0x07
+
+uart_hw_t *uart_get_hw(uart_inst_t *uart);
+uint uart_get_index(uart_inst_t *uart);
+bool uart_is_writable(uart_inst_t *uart);
+
+void hw_set_bits(volatile uint32_t *reg, uint32_t mask);
+void hw_clear_bits(volatile uint32_t *reg, uint32_t mask);
+void hw_write_masked(volatile uint32_t *reg, uint32_t values, uint32_t mask);
+
+// Moves up to max bytes from the TX FIFO onto the wire (out), then raises
+// the TX interrupt if the FIFO is at or below the trigger level. Returns
+// the number of bytes moved.
+size_t fake_uart_shift(uart_inst_t *uart, uint8_t *out, size_t max);
+size_t fake_uart_tx_level(uart_inst_t *uart);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef FAKE_PICO_STDLIB_H
+#define FAKE_PICO_STDLIB_H
+
+// Just enough of the Pico SDK for the host tests. Time only moves when a
+// test calls fake_advance_us().
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef unsigned int uint;
+
+uint32_t time_us_32(void);
+uint64_t time_us_64(void);
+
+void fake_advance_us(uint32_t us);
+
+// Hardware alarms are accepted but never fire; a test that needs one
+// calls the callback itself
+typedef int32_t alarm_id_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void *user_data);
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past);
+bool cancel_alarm(alarm_id_t id);
+
+typedef struct repeating_timer repeating_timer_t;
+typedef bool (*repeating_timer_callback_t)(repeating_timer_t *rt);
+struct repeating_timer {
+    int64_t delay_us;
+    repeating_timer_callback_t callback;
+    void *user_data;
+};
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data,
+                            repeating_timer_t *out);
+bool cancel_repeating_timer(repeating_timer_t *timer);
+
+#endif
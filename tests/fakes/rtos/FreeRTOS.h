@@ -0,0 +1,24 @@
+#ifndef FAKE_FREERTOS_H
+#define FAKE_FREERTOS_H
+
+// For single-threaded tests that do not need the real kernel (see
+// freertos_host): critical sections have nothing to guard and the tick
+// count follows the fake clock.
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#define pdFALSE 0
+#define pdTRUE  1
+#define pdPASS  pdTRUE
+#define configTICK_RATE_HZ 100
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFF)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((TickType_t)(ms) * configTICK_RATE_HZ) / 1000))
+
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+
+#endif
@@ -0,0 +1,6 @@
+#include "pico/stdlib.h"
+#include "task.h"
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(time_us_64() / (1000000 / configTICK_RATE_HZ));
+}
@@ -0,0 +1,8 @@
+#ifndef FAKE_TASK_H
+#define FAKE_TASK_H
+
+#include "FreeRTOS.h"
+
+TickType_t xTaskGetTickCount(void);
+
+#endif
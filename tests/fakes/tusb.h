@@ -0,0 +1,28 @@
+#ifndef FAKE_TUSB_H
+#define FAKE_TUSB_H
+
+// The TinyUSB CDC calls transport_cdc.c makes, over two byte FIFOs the
+// test plays the USB host on
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "tusb_config.h"
+
+bool tud_cdc_connected(void);
+uint32_t tud_cdc_available(void);
+uint32_t tud_cdc_read(void *buffer, uint32_t bufsize);
+uint32_t tud_cdc_write_available(void);
+uint32_t tud_cdc_write(const void *buffer, uint32_t bufsize);
+uint32_t tud_cdc_write_flush(void);
+
+void fake_cdc_set_connected(bool connected);
+// What the device wrote, as the host would read it
+size_t fake_cdc_host_read(uint8_t *data, size_t len);
+// Host -> device; returns the bytes that fit in the RX FIFO
+size_t fake_cdc_host_write(const uint8_t *data, size_t len);
+// Calls into TinyUSB from a thread other than the one marked as the USB task
+uint32_t fake_tusb_foreign_calls(void);
+void fake_tusb_set_owner(void);
+
+#endif
@@ -0,0 +1,13 @@
+#include "FreeRTOS.h"
+#include "task.h"
+
+// Storage for the idle task, which configSUPPORT_STATIC_ALLOCATION leaves
+// to the application
+void vApplicationGetIdleTaskMemory(StaticTask_t **tcb, StackType_t **stack, uint32_t *depth) {
+    static StaticTask_t idle_tcb;
+    static StackType_t idle_stack[configMINIMAL_STACK_SIZE];
+
+    *tcb = &idle_tcb;
+    *stack = idle_stack;
+    *depth = configMINIMAL_STACK_SIZE;
+}
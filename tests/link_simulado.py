@@ -0,0 +1,132 @@
+"""Link serial simulado para testar python/main.py sem hardware.
+
+O relógio é simulado: cada leitura da serial avança o tempo em `passo`
+segundos e entrega os bytes que o "dispositivo" agendou até ali. O
+teclado e a serial de verdade são trocados por stubs antes de importar
+main.py, então os testes rodam em qualquer máquina.
+"""
+
+import sys
+import types
+
+import protocol
+
+
+class FimSimulacao(Exception):
+    """Encerra o laço de controle() quando o roteiro acaba."""
+
+
+class TecladoFalso(types.ModuleType):
+    """Substitui o módulo keyboard: só registra o que seria enviado ao SO."""
+
+    def __init__(self):
+        super().__init__('keyboard')
+        self.relogio = lambda: 0.0
+        self.pressionadas = set()
+        self.historico = []
+
+    def press(self, tecla):
+        self.pressionadas.add(tecla)
+        self.historico.append((self.relogio(), 'press', tecla))
+
+    def release(self, tecla):
+        self.pressionadas.discard(tecla)
+        self.historico.append((self.relogio(), 'release', tecla))
+
+    def send(self, tecla):
+        self.historico.append((self.relogio(), 'send', tecla))
+
+
+def importar_main():
+    """Importa python/main.py com teclado e serial falsos."""
+    teclado = sys.modules.get('keyboard')
+    if not isinstance(teclado, TecladoFalso):
+        teclado = TecladoFalso()
+        sys.modules['keyboard'] = teclado
+    sys.modules.setdefault('serial', types.ModuleType('serial'))
+    import main
+    return main, teclado
+
+
+class LinkSimulado:
+    """Faz o papel da serial em controle(): ser.read, ser.write, ser.in_waiting."""
+
+    def __init__(self, main, teclado, fim, passo=0.005):
+        self.t = 0.0
+        self.fim = fim
+        self.passo = passo
+        # Linha parada antes do primeiro quadro: o decoder já começa
+        # sincronizado
+        self.agenda = []
+        self.linha = bytearray(b'\x00')
+        self.comandos = []
+        # ao_receber(t, payload) faz o papel do firmware para cada comando
+        self.ao_receber = None
+        # a_cada_passo(t) roda a parte do firmware que depende só do tempo
+        self.a_cada_passo = None
+        self.seq = 0
+        # Formato em que o "dispositivo" está enviando: com FEC, paridade
+        # em todo quadro
+        self.fec = False
+        self._comandos_rx = protocol.FrameDecoder()
+        self._comandos_rx.feed(b'\x00')
+        teclado.relogio = lambda: self.t
+        main.monotonic = lambda: self.t
+
+    # Lado do dispositivo
+
+    def enviar(self, t, payload, seq=None):
+        """Agenda um quadro [seq, código, dados...]. Sem seq, ele é
+        preenchido na saída, na ordem em que os quadros vão para o link."""
+        self.agenda.append((t, bytes(payload), seq))
+        self.agenda.sort(key=lambda item: item[0])
+
+    def borda(self, t, codigo, soltar=False):
+        self.enviar(t, protocol.EVENT.pack(0, codigo | (0x80 if soltar else 0), 1))
+
+    def hello(self, t, formatos, botoes=(0x01, 0x02, 0x03, 0x04)):
+        self.enviar(t, protocol.HELLO.pack(0, protocol.CODE_HELLO, protocol.VERSAO_PROTOCOLO,
+                                           formatos, 1, 10, 25, 0x06, 3, len(botoes)) + bytes(botoes))
+
+    def heartbeats(self, inicio, fim, intervalo=0.25):
+        t = inicio
+        while t < fim:
+            self.enviar(t, protocol.HEARTBEAT.pack(0, protocol.CODE_HEARTBEAT))
+            t += intervalo
+
+    def estado(self, t, codigos, pot=0):
+        mascara = sum(1 << c for c in codigos)
+        self.enviar(t, protocol.STATE.pack(0, protocol.CODE_STATE, mascara, 0, pot))
+
+    # Lado do host (serial)
+
+    @property
+    def in_waiting(self):
+        return 0
+
+    def read(self, n=1):
+        self.t += self.passo
+        if self.t > self.fim:
+            raise FimSimulacao
+        if self.a_cada_passo is not None:
+            self.a_cada_passo(self.t)
+        while self.agenda and self.agenda[0][0] <= self.t:
+            _, payload, seq = self.agenda.pop(0)
+            if seq is None:
+                seq = self.seq
+                self.seq = (self.seq + 1) & 0xFF
+            codificar = protocol.encode_frame_fec if self.fec else protocol.encode_frame
+            self.linha += codificar(bytes([seq]) + payload[1:])
+        dados = bytes(self.linha)
+        self.linha.clear()
+        return dados
+
+    def write(self, dados):
+        for payload in self._comandos_rx.feed(bytes(dados)):
+            self.comandos.append((self.t, payload))
+            if self.ao_receber is not None:
+                self.ao_receber(self.t, payload)
+
+    def comandos_enviados(self, cmd):
+        """Instantes em que o host mandou o comando cmd."""
+        return [t for t, payload in self.comandos if payload and payload[0] == cmd]
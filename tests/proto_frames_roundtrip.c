@@ -0,0 +1,148 @@
+// Gerado por protocol/gerar.py a partir de protocol/schema.json. Não edite.
+#include <stdio.h>
+#include "proto_frames.h"
+
+static void dump(const char *name, const long long *values, int count,
+                 const uint8_t *out, size_t len) {
+    printf("%s", name);
+    for (int i = 0; i < count; i++)
+        printf(" %lld", values[i]);
+    printf(" ");
+    for (size_t i = 0; i < len; i++)
+        printf("%02x", out[i]);
+    printf("\n");
+}
+
+int main(void) {
+    uint8_t out[64];
+    size_t len;
+
+    {
+        static const long long values[] = {129, 131, -4662};
+        len = proto_pack_event(out, 129, 131, -4662);
+        if (len != PROTO_FRAME_EVENT_LEN)
+            return 1;
+        dump("event", values, 3, out, len);
+    }
+    {
+        static const long long values[] = {129, 131, -4662, 2214855687, 34057};
+        len = proto_pack_event_timed(out, 129, 131, -4662, 2214855687, 34057);
+        if (len != PROTO_FRAME_EVENT_TIMED_LEN)
+            return 1;
+        dump("event_timed", values, 5, out, len);
+    }
+    {
+        static const long long values[] = {129, PROTO_CODE_HEARTBEAT};
+        len = proto_pack_heartbeat(out, 129);
+        if (len != PROTO_FRAME_HEARTBEAT_LEN)
+            return 1;
+        dump("heartbeat", values, 2, out, len);
+    }
+    {
+        static const long long values[] = {129, PROTO_CODE_STATE, 33541, 135, -4664};
+        len = proto_pack_state(out, 129, 33541, 135, -4664);
+        if (len != PROTO_FRAME_STATE_LEN)
+            return 1;
+        dump("state", values, 5, out, len);
+    }
+    {
+        static const long long values[] = {129, PROTO_CODE_PONG, 33541};
+        len = proto_pack_pong(out, 129, 33541);
+        if (len != PROTO_FRAME_PONG_LEN)
+            return 1;
+        dump("pong", values, 3, out, len);
+    }
+    {
+        static const long long values[] = {129, PROTO_CODE_CMD_OK, 133, 135};
+        len = proto_pack_cmd_ok(out, 129, 133, 135);
+        if (len != PROTO_FRAME_CMD_OK_LEN)
+            return 1;
+        dump("cmd_ok", values, 4, out, len);
+    }
+    {
+        static const long long values[] = {129, PROTO_CODE_HELLO, 133, 135, 137, 139, 141, 143, 145, 147};
+        len = proto_pack_hello(out, 129, 133, 135, 137, 139, 141, 143, 145, 147);
+        if (len != PROTO_FRAME_HELLO_LEN)
+            return 1;
+        dump("hello", values, 10, out, len);
+    }
+    {
+        static const long long values[] = {129, PROTO_CODE_TIME, 33541, 2214855687, 2231698697};
+        len = proto_pack_time(out, 129, 33541, 2214855687, 2231698697);
+        if (len != PROTO_FRAME_TIME_LEN)
+            return 1;
+        dump("time", values, 5, out, len);
+    }
+    {
+        static const long long values[] = {129, PROTO_CODE_PROBE, 2198012677};
+        len = proto_pack_probe(out, 129, 2198012677);
+        if (len != PROTO_FRAME_PROBE_LEN)
+            return 1;
+        dump("probe", values, 3, out, len);
+    }
+    {
+        static const long long values[] = {129, 131, 33541, 33799, 34057};
+        len = proto_pack_link(out, 129, 131, 33541, 33799, 34057);
+        if (len != PROTO_FRAME_LINK_LEN)
+            return 1;
+        dump("link", values, 5, out, len);
+    }
+    printf("cmd_ping %d\n", PROTO_CMD_PING_LEN);
+    printf("cmd_set_scan %d\n", PROTO_CMD_SET_SCAN_LEN);
+    printf("cmd_set_thresh %d\n", PROTO_CMD_SET_THRESH_LEN);
+    printf("cmd_remap %d\n", PROTO_CMD_REMAP_LEN);
+    printf("cmd_get_stats %d\n", PROTO_CMD_GET_STATS_LEN);
+    printf("cmd_resync %d\n", PROTO_CMD_RESYNC_LEN);
+    printf("cmd_ack %d\n", PROTO_CMD_ACK_LEN);
+    printf("cmd_set_format %d\n", PROTO_CMD_SET_FORMAT_LEN);
+    printf("cmd_hello %d\n", PROTO_CMD_HELLO_LEN);
+    printf("cmd_get_links %d\n", PROTO_CMD_GET_LINKS_LEN);
+    printf("cmd_keepalive %d\n", PROTO_CMD_KEEPALIVE_LEN);
+    printf("cmd_time %d\n", PROTO_CMD_TIME_LEN);
+    printf("cmd_set_report %d\n", PROTO_CMD_SET_REPORT_LEN);
+    printf("cmd_echo %d\n", PROTO_CMD_ECHO_LEN);
+    printf("CODE_PONG %d\n", PROTO_CODE_PONG);
+    printf("CODE_STATS %d\n", PROTO_CODE_STATS);
+    printf("CODE_CMD_OK %d\n", PROTO_CODE_CMD_OK);
+    printf("CODE_HEARTBEAT %d\n", PROTO_CODE_HEARTBEAT);
+    printf("CODE_STATE %d\n", PROTO_CODE_STATE);
+    printf("CODE_HELLO %d\n", PROTO_CODE_HELLO);
+    printf("CODE_LINKS %d\n", PROTO_CODE_LINKS);
+    printf("CODE_TIME %d\n", PROTO_CODE_TIME);
+    printf("CODE_PROBE %d\n", PROTO_CODE_PROBE);
+    printf("CMD_PING %d\n", PROTO_CMD_PING);
+    printf("CMD_SET_SCAN %d\n", PROTO_CMD_SET_SCAN);
+    printf("CMD_SET_THRESH %d\n", PROTO_CMD_SET_THRESH);
+    printf("CMD_REMAP %d\n", PROTO_CMD_REMAP);
+    printf("CMD_GET_STATS %d\n", PROTO_CMD_GET_STATS);
+    printf("CMD_RESYNC %d\n", PROTO_CMD_RESYNC);
+    printf("CMD_ACK %d\n", PROTO_CMD_ACK);
+    printf("CMD_SET_FORMAT %d\n", PROTO_CMD_SET_FORMAT);
+    printf("CMD_HELLO %d\n", PROTO_CMD_HELLO);
+    printf("CMD_GET_LINKS %d\n", PROTO_CMD_GET_LINKS);
+    printf("CMD_KEEPALIVE %d\n", PROTO_CMD_KEEPALIVE);
+    printf("CMD_TIME %d\n", PROTO_CMD_TIME);
+    printf("CMD_SET_REPORT %d\n", PROTO_CMD_SET_REPORT);
+    printf("CMD_ECHO %d\n", PROTO_CMD_ECHO);
+    printf("LINK_HC06 %d\n", PROTO_LINK_HC06);
+    printf("LINK_CDC %d\n", PROTO_LINK_CDC);
+    printf("FMT_COMPACT_ANALOG %d\n", PROTO_FMT_COMPACT_ANALOG);
+    printf("FMT_EDGE_TIME %d\n", PROTO_FMT_EDGE_TIME);
+    printf("FMT_FEC %d\n", PROTO_FMT_FEC);
+    printf("REC_DELTA %d\n", PROTO_REC_DELTA);
+    printf("REC_KEY %d\n", PROTO_REC_KEY);
+    printf("REC_RUN %d\n", PROTO_REC_RUN);
+    printf("SCAN_BUTTON %d\n", PROTO_SCAN_BUTTON);
+    printf("SCAN_POT %d\n", PROTO_SCAN_POT);
+    printf("SCAN_FSR %d\n", PROTO_SCAN_FSR);
+    printf("SCAN_HEARTBEAT %d\n", PROTO_SCAN_HEARTBEAT);
+    printf("THRESH_FSR_PRESS %d\n", PROTO_THRESH_FSR_PRESS);
+    printf("THRESH_FSR_LVL2 %d\n", PROTO_THRESH_FSR_LVL2);
+    printf("THRESH_FSR_LVL3 %d\n", PROTO_THRESH_FSR_LVL3);
+    printf("THRESH_POT_DEADBAND %d\n", PROTO_THRESH_POT_DEADBAND);
+    printf("THRESH_BATCH_LIMIT_MS %d\n", PROTO_THRESH_BATCH_LIMIT_MS);
+    printf("THRESH_ANALOG_HOLD_MS %d\n", PROTO_THRESH_ANALOG_HOLD_MS);
+    printf("STATUS_OK %d\n", PROTO_STATUS_OK);
+    printf("STATUS_ERR %d\n", PROTO_STATUS_ERR);
+    return 0;
+}
@@ -0,0 +1,238 @@
+#include <string.h>
+#include "check.h"
+#include "analog_pack.h"
+#include "protocol.h"
+
+#define POT_PERIOD_US 50000
+#define SESSION_UPDATES 20000
+
+// Same rules as AnalogDecoder in python/protocol.py
+typedef struct {
+    int16_t value[ANALOG_CHANNELS];
+    bool known[ANALOG_CHANNELS];
+    int updates;
+    int rejected;
+} ref_decoder_t;
+
+static size_t get_varint(const uint8_t *in, size_t len, size_t i, uint16_t *out) {
+    uint16_t n = 0;
+    int shift = 0;
+    while (i < len) {
+        uint8_t b = in[i++];
+        n |= (uint16_t)(b & 0x7F) << shift;
+        shift += 7;
+        if (!(b & 0x80))
+            break;
+    }
+    *out = n;
+    return i;
+}
+
+static int16_t unzigzag(uint16_t n) {
+    return (int16_t)((n >> 1) ^ -(n & 1));
+}
+
+// Returns false on a record the decoder does not understand
+static bool ref_feed(ref_decoder_t *d, const uint8_t *in, size_t len) {
+    size_t i = 0;
+    uint16_t n;
+
+    while (i < len) {
+        uint8_t type = in[i] & 0xF0, ch = in[i] & 0x0F;
+        i++;
+        if (type == PROTO_REC_KEY) {
+            if (i + 2 > len)
+                return false;
+            d->value[ch] = (int16_t)((in[i] << 8) | in[i + 1]);
+            d->known[ch] = true;
+            d->updates++;
+            i += 2;
+        } else if (type == PROTO_REC_DELTA || type == PROTO_REC_RUN) {
+            int count = 1;
+            if (type == PROTO_REC_RUN) {
+                if (i >= len)
+                    return false;
+                count = in[i++];
+            }
+            for (int k = 0; k < count; k++) {
+                i = get_varint(in, len, i, &n);
+                if (!d->known[ch]) {
+                    d->rejected++;
+                    continue;
+                }
+                d->value[ch] += unzigzag(n);
+                d->updates++;
+            }
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Every update arrives in order and the host ends with the last values
+static void test_roundtrip(void) {
+    analog_pack_t ap;
+    ref_decoder_t dec = {0};
+    int16_t truth[ANALOG_CHANNELS] = {0};
+    uint8_t out[PROTO_MAX_PAYLOAD];
+    int sent = 0;
+
+    analog_pack_init(&ap);
+    for (int round = 0; round < 5000; round++) {
+        // Runs of one channel, with the odd switch to another
+        uint8_t ch = (check_rand() % 4 == 0) ? check_rand() % 3 : 0;
+        int16_t step = (int16_t)(check_rand() % 81) - 40;
+        if (check_rand() % 50 == 0)
+            step *= 100;
+        truth[ch] += step;
+        CHECK(analog_pack_add(&ap, ch, truth[ch], 0));
+        sent++;
+        if (analog_pack_full(&ap)) {
+            size_t n = analog_pack_records(&ap, out, PROTO_MAX_PAYLOAD - 1);
+            CHECK(n > 0 && ap.count == 0);
+            CHECK(ref_feed(&dec, out, n));
+        }
+    }
+    while (ap.count > 0)
+        CHECK(ref_feed(&dec, out, analog_pack_records(&ap, out, PROTO_MAX_PAYLOAD - 1)));
+
+    CHECK(dec.updates == sent);
+    CHECK(dec.rejected == 0);
+    for (int ch = 0; ch < 3; ch++)
+        CHECK(dec.value[ch] == truth[ch]);
+}
+
+// A channel gets an absolute value at least every ANALOG_KEY_EVERY
+// updates, even in the middle of a run
+static void test_keyframes(void) {
+    analog_pack_t ap;
+    uint8_t out[PROTO_MAX_PAYLOAD];
+    int since_key = 0, keys = 0;
+
+    analog_pack_init(&ap);
+    for (int i = 0; i < 10 * ANALOG_KEY_EVERY; i++) {
+        analog_pack_add(&ap, 2, (int16_t)(i * 3), 0);
+        if (!analog_pack_full(&ap))
+            continue;
+        size_t n = analog_pack_records(&ap, out, sizeof(out));
+        for (size_t k = 0; k < n;) {
+            uint8_t type = out[k] & 0xF0;
+            CHECK((out[k] & 0x0F) == 2);
+            if (type == PROTO_REC_KEY) {
+                keys++;
+                since_key = 0;
+                k += 3;
+            } else if (type == PROTO_REC_RUN) {
+                since_key += out[k + 1];
+                k += 2 + out[k + 1];  // deltas of 3 fit in one byte
+            } else {
+                since_key++;
+                k += 2;
+            }
+            CHECK(since_key <= ANALOG_KEY_EVERY);
+        }
+    }
+    CHECK(keys == 10);
+
+    // analog_pack_key() makes the next record absolute again
+    analog_pack_add(&ap, 2, 100, 0);
+    analog_pack_key(&ap);
+    CHECK(analog_pack_records(&ap, out, sizeof(out)) == 3);
+    CHECK(out[0] == (PROTO_REC_KEY | 2));
+}
+
+// Whatever does not fit stays held for the next frame
+static void test_room(void) {
+    analog_pack_t ap;
+    ref_decoder_t dec = {0};
+    uint8_t out[PROTO_MAX_PAYLOAD];
+
+    analog_pack_init(&ap);
+    for (int i = 0; i < ANALOG_RUN_MAX; i++)
+        analog_pack_add(&ap, 1, (int16_t)(i * 1000), 0);
+    CHECK(!analog_pack_add(&ap, 1, 0, 0));
+
+    CHECK(analog_pack_records(&ap, out, 2) == 0);
+    CHECK(ap.count == ANALOG_RUN_MAX);
+    for (size_t room = 3; ap.count > 0; room++) {
+        size_t n = analog_pack_records(&ap, out, room);
+        CHECK(n <= room);
+        CHECK(ref_feed(&dec, out, n));
+    }
+    CHECK(dec.updates == ANALOG_RUN_MAX);
+    CHECK(dec.value[1] == (ANALOG_RUN_MAX - 1) * 1000);
+}
+
+static void test_due(void) {
+    analog_pack_t ap;
+
+    analog_pack_init(&ap);
+    CHECK(!analog_pack_due(&ap, 0, 0));
+    analog_pack_add(&ap, 0, 1, 1000);
+    CHECK(analog_pack_due(&ap, 1000, 0));
+    CHECK(!analog_pack_due(&ap, 400999, 400000));
+    CHECK(analog_pack_due(&ap, 401000, 400000));
+    // time_us_32() wraps after ~71 minutes
+    analog_pack_init(&ap);
+    analog_pack_add(&ap, 0, 1, 0xFFFFFFF0u);
+    CHECK(!analog_pack_due(&ap, 100, 400000));
+}
+
+// A pot turned by hand, as pot_task reports it: one update per period
+// while it moves by more than the deadband, nothing while it rests.
+// Returns wire bytes per update with the TX loop holding up to hold_us.
+static double session_bytes_per_update(uint32_t hold_us) {
+    analog_pack_t ap;
+    ref_decoder_t dec = {0};
+    uint8_t payload[PROTO_MAX_PAYLOAD], frame[PROTO_MAX_FRAME];
+    uint32_t now = 0, wire = 0, seq = 0;
+    int16_t value = 2048;
+    int updates = 0, moving = 0;
+
+    check_rng_state = 0xC0FFEE;
+    analog_pack_init(&ap);
+    while (updates < SESSION_UPDATES) {
+        now += POT_PERIOD_US;
+        if (moving == 0 && check_rand() % 20 == 0)
+            moving = 5 + check_rand() % 40;
+        if (moving > 0) {
+            moving--;
+            int16_t step = 3 + check_rand() % 30;
+            value += (check_rand() & 1) ? step : -step;
+            if (value < 0) value = 0;
+            if (value > 4095) value = 4095;
+            analog_pack_add(&ap, 0, value, now);
+            updates++;
+        }
+        while (analog_pack_due(&ap, now, hold_us)) {
+            payload[0] = seq++;
+            size_t plen = 1 + analog_pack_records(&ap, &payload[1], sizeof(payload) - 1);
+            CHECK(ref_feed(&dec, &payload[1], plen - 1));
+            wire += proto_encode_frame(payload, plen, frame);
+        }
+    }
+    CHECK(dec.rejected == 0);
+    CHECK(dec.value[0] == value || ap.count > 0);
+    return (double)wire / updates;
+}
+
+static void test_session(void) {
+    // The original format: a 7-byte frame per update
+    double unheld = session_bytes_per_update(0);
+    double held = session_bytes_per_update(400000);
+
+    printf("pot session: %.2f B/update sent at once, %.2f B/update held 400 ms (7 B plain)\n",
+           unheld, held);
+    CHECK(held < 2.0);
+    CHECK(unheld < 7.0);
+}
+
+int main(void) {
+    test_roundtrip();
+    test_keyframes();
+    test_room();
+    test_due();
+    test_session();
+    return check_result("test_analog_pack");
+}
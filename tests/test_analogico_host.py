@@ -0,0 +1,35 @@
+"""Registros analógicos compactos no host (python/protocol.py): quadro-chave,
+delta, sequência de deltas (REC_RUN) e deltas sem base."""
+
+import unittest
+
+from protocol import REC_DELTA, REC_KEY, REC_RUN, AnalogDecoder
+
+
+class TestAnalogico(unittest.TestCase):
+    def test_chave_delta_e_sequencia(self):
+        dec = AnalogDecoder()
+        # canal 0 = 1000, +3, depois -1, +2, +300 numa sequência
+        dados = bytes([REC_KEY | 0, 0x03, 0xE8,
+                       REC_DELTA | 0, 6,
+                       REC_RUN | 0, 3, 1, 4, 0xD8, 0x04])
+        self.assertEqual(dec.feed(dados),
+                         [(0, 1000), (0, 1003), (0, 1002), (0, 1004), (0, 1304)])
+        self.assertEqual(dec.rejeitados, 0)
+
+    def test_sequencia_sem_base_e_rejeitada(self):
+        dec = AnalogDecoder()
+        dados = bytes([REC_RUN | 1, 2, 2, 2, REC_KEY | 1, 0x00, 0x10, REC_RUN | 1, 1, 2])
+        self.assertEqual(dec.feed(dados), [(1, 16), (1, 17)])
+        self.assertEqual(dec.rejeitados, 2)
+
+    def test_custo_por_atualizacao(self):
+        dec = AnalogDecoder()
+        dec.feed(bytes([REC_KEY | 0, 0x00, 0x00]))
+        dec.feed(bytes([REC_RUN | 0, 8]) + bytes([2] * 8))
+        # 2 quadros: (3 + 4) + (10 + 4) bytes para 9 atualizações
+        self.assertAlmostEqual(dec.bytes_no_fio / dec.atualizacoes, 21 / 9)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,231 @@
+#include <string.h>
+#include "check.h"
+#include "at_engine.h"
+#include "pico/stdlib.h"
+
+static char sent[512];
+static size_t sent_len;
+static bool line_idle = true;
+
+static bool port_write(const uint8_t *data, size_t len) {
+    memcpy(sent + sent_len, data, len);
+    sent_len += len;
+    sent[sent_len] = '\0';
+    return true;
+}
+
+static bool port_tx_idle(void) {
+    return line_idle;
+}
+
+static const at_port_t port = {.write = port_write, .tx_idle = port_tx_idle};
+
+typedef struct {
+    int calls;
+    bool ok;
+    char response[AT_LINE_MAX + 8];
+    size_t sent_at_on_send;
+} result_t;
+
+static void on_done(bool ok, const char *response, void *ctx) {
+    result_t *r = ctx;
+    r->calls++;
+    r->ok = ok;
+    strncpy(r->response, response, sizeof(r->response) - 1);
+}
+
+static void on_send(void *ctx) {
+    ((result_t *)ctx)->sent_at_on_send = sent_len;
+}
+
+static at_command_t command(const char *text, const char *expect, const char *fail, result_t *r) {
+    at_command_t cmd = {
+        .expect = expect,
+        .fail = fail,
+        .timeout_ms = 500,
+        .on_send = on_send,
+        .done = on_done,
+        .ctx = r,
+    };
+    strncpy(cmd.cmd, text, sizeof(cmd.cmd) - 1);
+    memset(r, 0, sizeof(*r));
+    return cmd;
+}
+
+static void reply(const char *text) {
+    for (const char *c = text; *c; c++)
+        at_engine_rx_from_isr((uint8_t)*c);
+}
+
+// Polls every 10 ms until the engine goes idle or max_ms have passed
+static void run(uint32_t max_ms) {
+    for (uint32_t t = 0; t < max_ms; t += 10) {
+        at_engine_poll();
+        fake_advance_us(10000);
+        if (!at_engine_busy())
+            break;
+    }
+}
+
+static void reset(void) {
+    at_engine_init(&port);
+    sent_len = 0;
+    line_idle = true;
+}
+
+// The HC-06 answers without CR/LF, so the partial line has to match
+static void test_ok_without_newline(void) {
+    result_t r;
+    at_command_t cmd = command("AT", "OK", NULL, &r);
+
+    reset();
+    CHECK(!at_engine_rx_from_isr('X'));  // nothing to capture yet
+    CHECK(at_engine_submit(&cmd));
+    at_engine_poll();
+    CHECK(strcmp(sent, "AT") == 0);
+    CHECK(r.sent_at_on_send == 0);
+    reply("OK");
+    at_engine_poll();
+    CHECK(r.calls == 1 && r.ok);
+    CHECK(strcmp(r.response, "OK") == 0);
+    CHECK(!at_engine_busy());
+}
+
+// Nothing is sent while a frame is still leaving the UART
+static void test_waits_for_idle_line(void) {
+    result_t r;
+    at_command_t cmd = command("AT+VERSION", "OK", NULL, &r);
+
+    reset();
+    line_idle = false;
+    CHECK(at_engine_submit(&cmd));
+    CHECK(at_engine_poll() == 1);
+    CHECK(at_engine_poll() == 1);
+    CHECK(sent_len == 0 && r.sent_at_on_send == 0);
+    line_idle = true;
+    at_engine_poll();
+    CHECK(strcmp(sent, "AT+VERSION") == 0);
+    reply("OKlinvorV1.8");
+    run(100);
+    CHECK(r.ok && strcmp(r.response, "OKlinvorV1.8") == 0);
+}
+
+static void test_multi_line_and_fail(void) {
+    result_t r;
+    at_command_t cmd = command("AT+NAMEstick", "OK", "ERROR", &r);
+
+    reset();
+    at_engine_submit(&cmd);
+    at_engine_poll();
+    reply("+NAME:stick\r\nOK\r\n");
+    run(100);
+    CHECK(r.ok && strcmp(r.response, "OK") == 0);
+
+    cmd = command("AT+PIN99999", "OK", "ERROR", &r);
+    at_engine_submit(&cmd);
+    at_engine_poll();
+    reply("ERROR:(1D)\r\n");
+    run(100);
+    CHECK(r.calls == 1 && !r.ok);
+}
+
+static void test_timeout(void) {
+    result_t r;
+    at_command_t cmd = command("AT", "OK", NULL, &r);
+
+    reset();
+    at_engine_submit(&cmd);
+    run(400);
+    CHECK(r.calls == 0 && at_engine_busy());
+    run(200);
+    CHECK(r.calls == 1 && !r.ok);
+    // Late reply bytes are not captured anymore
+    CHECK(!at_engine_rx_from_isr('O'));
+}
+
+// Commands run one at a time, in order; a full queue rejects the extra one
+static void test_queue(void) {
+    result_t r[AT_QUEUE_LEN + 1];
+    at_command_t cmd;
+    char text[8];
+
+    reset();
+    for (int i = 0; i <= AT_QUEUE_LEN; i++) {
+        snprintf(text, sizeof(text), "AT%d", i);
+        cmd = command(text, "OK", NULL, &r[i]);
+        CHECK(at_engine_submit(&cmd) == (i < AT_QUEUE_LEN));
+    }
+    for (int i = 0; i < AT_QUEUE_LEN; i++) {
+        at_engine_poll();
+        CHECK(r[i].sent_at_on_send == sent_len - 3);
+        reply("OK");
+        run(50);
+        CHECK(r[i].calls == 1 && r[i].ok);
+    }
+    CHECK(strcmp(sent, "AT0AT1AT2AT3") == 0);
+    CHECK(r[AT_QUEUE_LEN].calls == 0);
+}
+
+// Over-long commands are cut to AT_CMD_MAX - 1 characters, never overrun
+static void test_long_command(void) {
+    result_t r;
+    char text[AT_CMD_MAX + 10];
+    at_command_t cmd = command("", "OK", NULL, &r);
+
+    reset();
+    memset(text, 'A', sizeof(text) - 1);
+    text[sizeof(text) - 1] = '\0';
+    memcpy(cmd.cmd, text, sizeof(cmd.cmd));
+    CHECK(at_engine_submit(&cmd));
+    at_engine_poll();
+    CHECK(sent_len == AT_CMD_MAX - 1);
+    reply("OK");
+    run(50);
+    CHECK(r.ok);
+}
+
+// Random replies, with and without line breaks and longer than the RX
+// ring: exactly one callback each, never a match that is not there
+static void test_fuzz(void) {
+    static const char alphabet[] = "OKERRORAT+:\r\n0123456789abc";
+    char text[200];
+    result_t r;
+
+    reset();
+    for (int round = 0; round < 20000; round++) {
+        size_t len = check_rand() % sizeof(text);
+        for (size_t i = 0; i < len; i++)
+            text[i] = alphabet[check_rand() % (sizeof(alphabet) - 1)];
+        text[len] = '\0';
+
+        at_command_t cmd = command("AT", "OK", "ERROR", &r);
+        at_engine_submit(&cmd);
+        at_engine_poll();
+        for (size_t i = 0; i < len; i++) {
+            at_engine_rx_from_isr((uint8_t)text[i]);
+            if (check_rand() % 16 == 0)
+                at_engine_poll();
+        }
+        run(1000);
+
+        CHECK(r.calls == 1);
+        CHECK(strlen(r.response) < AT_LINE_MAX);
+        if (r.ok)
+            CHECK(strstr(r.response, "OK") != NULL);
+        // Short single-line replies fit everywhere: the verdict is exact
+        if (len < AT_LINE_MAX && strpbrk(text, "\r\n") == NULL && strstr(text, "ERROR") == NULL)
+            CHECK(r.ok == (strstr(text, "OK") != NULL));
+        sent_len = 0;
+    }
+}
+
+int main(void) {
+    test_ok_without_newline();
+    test_waits_for_idle_line();
+    test_multi_line_and_fail();
+    test_timeout();
+    test_queue();
+    test_long_command();
+    test_fuzz();
+    return check_result("test_at_engine");
+}
@@ -0,0 +1,99 @@
+#include "check.h"
+#include "batch_window.h"
+
+#define PACKET_US 15000
+#define LIMIT_US 50000
+#define FLOOR_US 20000
+#define QUEUED_US 80000  // RTT while packets queue in the module
+
+static uint32_t jitter(void) {
+    return check_rand() % 3000;
+}
+
+// A quiet link: RTT jitter well under a packet interval never opens it
+static void test_quiet(void) {
+    batch_window_t bw;
+
+    batch_window_init(&bw);
+    for (int i = 0; i < 500; i++) {
+        batch_window_probe(&bw, FLOOR_US + jitter(), PACKET_US, LIMIT_US);
+        CHECK(bw.window_us == 0);
+    }
+}
+
+// Without the host's packet interval there is no target to open at
+static void test_no_packet_estimate(void) {
+    batch_window_t bw;
+
+    batch_window_init(&bw);
+    batch_window_probe(&bw, FLOOR_US, 0, LIMIT_US);
+    for (int i = 0; i < 50; i++) {
+        batch_window_probe(&bw, QUEUED_US, 0, LIMIT_US);
+        CHECK(bw.window_us == 0);
+    }
+}
+
+// Congestion opens the window at half a packet, doubles it on every probe
+// up to the limit, and it halves back to 0 once the RTT settles
+static void test_congestion(void) {
+    batch_window_t bw;
+    uint32_t prev;
+    int probes;
+
+    batch_window_init(&bw);
+    for (int i = 0; i < 20; i++)
+        batch_window_probe(&bw, FLOOR_US + jitter(), PACKET_US, LIMIT_US);
+    CHECK(bw.window_us == 0);
+
+    // Open
+    for (probes = 0; bw.window_us == 0 && probes < 20; probes++)
+        batch_window_probe(&bw, QUEUED_US + jitter(), PACKET_US, LIMIT_US);
+    CHECK(probes < 5);
+    CHECK(bw.window_us == PACKET_US / 2);
+
+    // Double
+    batch_window_probe(&bw, QUEUED_US + jitter(), PACKET_US, LIMIT_US);
+    CHECK(bw.window_us == PACKET_US);
+    batch_window_probe(&bw, QUEUED_US + jitter(), PACKET_US, LIMIT_US);
+    CHECK(bw.window_us == 2 * PACKET_US);
+    batch_window_probe(&bw, QUEUED_US + jitter(), PACKET_US, LIMIT_US);
+    CHECK(bw.window_us == LIMIT_US);
+    for (int i = 0; i < 5; i++) {
+        batch_window_probe(&bw, QUEUED_US + jitter(), PACKET_US, LIMIT_US);
+        CHECK(bw.window_us == LIMIT_US);
+    }
+
+    // Halve: the smoothed RTT takes a few probes to come down, then the
+    // window halves on each one
+    prev = bw.window_us;
+    for (probes = 0; bw.window_us > 0 && probes < 100; probes++) {
+        batch_window_probe(&bw, FLOOR_US + jitter(), PACKET_US, LIMIT_US);
+        CHECK(bw.window_us == prev || bw.window_us == prev / 2);
+        if (bw.window_us != prev)
+            CHECK(bw.window_us == prev / 2);
+        prev = bw.window_us;
+    }
+    CHECK(bw.window_us == 0);
+    CHECK(probes < 40);
+}
+
+// A smaller limit caps the window as soon as it opens
+static void test_limit(void) {
+    batch_window_t bw;
+
+    batch_window_init(&bw);
+    batch_window_probe(&bw, FLOOR_US, PACKET_US, 5000);
+    for (int i = 0; i < 20; i++) {
+        batch_window_probe(&bw, QUEUED_US, PACKET_US, 5000);
+        CHECK(bw.window_us <= 5000);
+    }
+    CHECK(bw.window_us == 5000);
+}
+
+int main(void) {
+    test_quiet();
+    test_no_packet_estimate();
+    test_congestion();
+    test_limit();
+    return check_result("test_batch_window");
+}
@@ -0,0 +1,87 @@
+#include <time.h>
+#include "check.h"
+#include "event_bus.h"
+
+// A scanner posting at its period while a flood task hammers the bus and
+// nobody drains the subscriber queues (transport stalled): the scanner
+// must keep its period and never wait inside bus_post.
+
+#define PERIODS      200
+#define DEPTH        4
+#define STACK_WORDS  (configMINIMAL_STACK_SIZE * 4)
+
+static bus_subscriber_t edges, analog;
+static event_t edges_storage[DEPTH], analog_storage[DEPTH];
+
+static volatile bool flooding = true;
+static uint32_t flood_posts = 0;
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void flood_task(void *p) {
+    (void)p;
+    while (flooding) {
+        bus_post_event(EV_SRC_POT, 0, (int16_t)flood_posts);
+        bus_post_event(EV_SRC_FSR, 7, flood_posts & 1);
+        flood_posts++;
+        taskYIELD();
+    }
+    vTaskSuspend(NULL);
+}
+
+static void scanner_task(void *p) {
+    (void)p;
+    TickType_t wake = xTaskGetTickCount();
+    int late = 0;
+    double worst_post = 0;
+
+    for (int i = 0; i < PERIODS; i++) {
+        vTaskDelayUntil(&wake, 1);
+        if (xTaskGetTickCount() != wake)
+            late++;
+
+        double t0 = now_ms();
+        bus_post_event(EV_SRC_BUTTON, 1, i & 1);
+        double took = now_ms() - t0;
+        if (took > worst_post)
+            worst_post = took;
+    }
+    flooding = false;
+
+    bus_stats_t btn, fsr, pot;
+    bus_get_stats(EV_SRC_BUTTON, &btn);
+    bus_get_stats(EV_SRC_FSR, &fsr);
+    bus_get_stats(EV_SRC_POT, &pot);
+    printf("scanner: %d periods, %d late, worst post %.3f ms; flood posts %u\n",
+           PERIODS, late, worst_post, (unsigned)flood_posts);
+    printf("drops: button %u, fsr %u; pot coalesced %u\n",
+           (unsigned)btn.drops, (unsigned)fsr.drops, (unsigned)pot.coalesced);
+
+    // A post preempted by the tick can lose one time slice to the flood
+    // task, never more
+    CHECK(worst_post < 2 * 1000.0 / configTICK_RATE_HZ);
+    CHECK(late * 20 <= PERIODS);
+    CHECK(flood_posts > 10 * PERIODS);
+    // Nothing got through, and none of it vanished silently
+    CHECK(btn.posted == PERIODS);
+    CHECK(btn.drops + fsr.drops >= btn.posted + fsr.posted - 2 * DEPTH);
+    CHECK(edges.overflowed);
+    CHECK(pot.coalesced > 0);
+
+    vTaskEndScheduler();
+}
+
+int main(void) {
+    bus_subscribe(&edges, EV_MASK(EV_SRC_BUTTON) | EV_MASK(EV_SRC_FSR), edges_storage, DEPTH);
+    bus_subscribe(&analog, EV_MASK(EV_SRC_POT), analog_storage, DEPTH);
+
+    // Same priority as the firmware's input tasks
+    xTaskCreate(scanner_task, "SCAN", STACK_WORDS, NULL, 1, NULL);
+    xTaskCreate(flood_task, "FLOOD", STACK_WORDS, NULL, 1, NULL);
+    vTaskStartScheduler();
+    return check_result("test_bus_saturation");
+}
@@ -0,0 +1,112 @@
+#include "check.h"
+#include "event_bus.h"
+
+// Runs before the scheduler starts, like main() does when wiring the bus:
+// every call below is non-blocking, so no task is needed.
+
+#define DEPTH 4
+
+static bus_subscriber_t edges, pots, all;
+static event_t edges_storage[DEPTH], pots_storage[2], all_storage[DEPTH];
+
+static void post(uint8_t source, uint8_t code, int16_t value) {
+    bus_post_event(source, code, value);
+}
+
+static int drain(bus_subscriber_t *sub, event_t *out, int max) {
+    int n = 0;
+    event_t ev;
+    while (bus_receive(sub, &ev, 0)) {
+        if (n < max)
+            out[n] = ev;
+        n++;
+    }
+    return n;
+}
+
+// Only the sources in the mask reach a subscriber
+static void test_routing(void) {
+    event_t got[8];
+
+    post(EV_SRC_BUTTON, 1, 1);
+    post(EV_SRC_POT, 0, 100);
+    CHECK(drain(&edges, got, 8) == 1 && got[0].source == EV_SRC_BUTTON);
+    CHECK(drain(&pots, got, 8) == 1 && got[0].value == 100);
+    CHECK(drain(&all, got, 8) == 2);
+}
+
+// A full edge queue loses its oldest entry, never the new edge, and the
+// subscriber is told to resync
+static void test_drop_oldest(void) {
+    bus_stats_t before, after;
+    event_t got[8];
+
+    bus_get_stats(EV_SRC_BUTTON, &before);
+    edges.overflowed = false;
+    for (int i = 0; i < DEPTH + 2; i++)
+        post(EV_SRC_BUTTON, (uint8_t)i, i & 1);
+    bus_get_stats(EV_SRC_BUTTON, &after);
+
+    CHECK(edges.overflowed);
+    CHECK(after.drops - before.drops >= 2);
+    CHECK(drain(&edges, got, 8) == DEPTH);
+    CHECK(got[0].code == 2 && got[DEPTH - 1].code == DEPTH + 1);
+    drain(&all, got, 8);
+}
+
+// Pot readings merge into one slot per code: the reader sees the latest
+// value, however many were posted
+static void test_coalesce(void) {
+    bus_stats_t before, after;
+    event_t got[8];
+
+    bus_get_stats(EV_SRC_POT, &before);
+    for (int v = 0; v < 50; v++)
+        post(EV_SRC_POT, 0, (int16_t)v);
+    bus_get_stats(EV_SRC_POT, &after);
+
+    CHECK(drain(&pots, got, 8) == 1);
+    CHECK(got[0].value == 49);
+    CHECK(after.coalesced - before.coalesced >= 49);
+    CHECK(!pots.overflowed);
+    drain(&all, got, 8);
+}
+
+static void test_drop_newest(void) {
+    event_t got[8];
+
+    bus_set_policy(EV_SRC_FSR, BUS_DROP_NEWEST);
+    for (int i = 0; i < DEPTH + 3; i++)
+        post(EV_SRC_FSR, (uint8_t)i, 1);
+    CHECK(drain(&edges, got, 8) == DEPTH);
+    CHECK(got[0].code == 0 && got[DEPTH - 1].code == DEPTH - 1);
+    bus_set_policy(EV_SRC_FSR, BUS_DROP_OLDEST);
+    drain(&all, got, 8);
+}
+
+// The input state follows the producers even when queues overflow
+static void test_state(void) {
+    input_state_t st;
+
+    for (uint8_t code = 0; code < 8; code++)
+        post(EV_SRC_BUTTON, code, 1);
+    post(EV_SRC_BUTTON, 3, 0);
+    post(EV_SRC_POT, 0, -5);
+    bus_get_state(&st);
+    CHECK(st.pressed == (0xFF & ~(1u << 3)));
+    CHECK(st.pot == -5);
+}
+
+int main(void) {
+    bus_subscribe(&edges, EV_MASK(EV_SRC_BUTTON) | EV_MASK(EV_SRC_FSR), edges_storage, DEPTH);
+    bus_subscribe(&pots, EV_MASK(EV_SRC_POT), pots_storage, 2);
+    bus_subscribe(&all, EV_MASK(EV_SRC_BUTTON) | EV_MASK(EV_SRC_FSR) | EV_MASK(EV_SRC_POT),
+                  all_storage, DEPTH);
+
+    test_routing();
+    test_drop_oldest();
+    test_coalesce();
+    test_drop_newest();
+    test_state();
+    return check_result("test_event_bus");
+}
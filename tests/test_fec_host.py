@@ -0,0 +1,102 @@
+"""FEC do lado do host (python/protocol.py): vetores conhecidos iguais aos
+de tests/test_framing.c e injeção de erros num fluxo de bordas."""
+
+import random
+import unittest
+
+from protocol import CODE_HELLO, FrameDecoder, encode_frame, encode_frame_fec
+from proto_frames import EVENT, HELLO
+
+QUADROS = 20000
+
+
+def bordas(rng):
+    return [EVENT.pack(i & 0xFF, rng.randrange(1, 16), rng.randrange(2)) for i in range(QUADROS)]
+
+
+def corromper(quadro, rng, erros, delimitador):
+    """Troca `erros` bytes distintos do quadro por outros valores; o
+    delimitador final só entra no sorteio se `delimitador`."""
+    quadro = bytearray(quadro)
+    for i in rng.sample(range(len(quadro) - (0 if delimitador else 1)), erros):
+        quadro[i] ^= rng.randrange(1, 256)
+    return bytes(quadro)
+
+
+def injetar(fec, erros, delimitador=False, semente=1):
+    """Passa QUADROS bordas, cada uma com `erros` bytes trocados, por um
+    FrameDecoder. Retorna (certos, falsos): quadros entregues iguais ao
+    original e quadros entregues que não existiam."""
+    rng = random.Random(semente)
+    originais = bordas(rng)
+    codificar = encode_frame_fec if fec else encode_frame
+    dec = FrameDecoder()
+    dec.fec = fec
+    dec.feed(b'\x00')
+    certos = falsos = 0
+    for payload in originais:
+        # Um delimitador limpo depois de cada quadro: um erro não se espalha
+        # para o seguinte
+        for recebido in dec.feed(corromper(codificar(payload), rng, erros, delimitador) + b'\x00'):
+            if recebido == payload:
+                certos += 1
+            else:
+                falsos += 1
+    return certos, falsos
+
+
+class TestFec(unittest.TestCase):
+    def test_vetores(self):
+        # Os mesmos de test_fec_known() em tests/test_framing.c
+        self.assertEqual(encode_frame_fec(bytes([0x12, 0x05, 0x00, 0x01])).hex(),
+                         '03120503015d034b5400')
+        self.assertEqual(encode_frame_fec(bytes([0, 0, 0, 0xFF, 0xFF])).hex(),
+                         '01010104ffff1d0318e900')
+
+    def test_sem_erros(self):
+        for fec in (False, True):
+            self.assertEqual(injetar(fec, 0), (QUADROS, 0))
+
+    def test_um_byte_errado(self):
+        certos_fec, falsos_fec = injetar(True, 1)
+        certos, falsos = injetar(False, 1)
+        print(f"\n1 byte errado no quadro: {100 * certos_fec / QUADROS:.1f}% certos com FEC, "
+              f"{100 * certos / QUADROS:.1f}% sem")
+        # Só escapam os erros que criam um 0x00 no meio do quadro
+        self.assertGreater(certos_fec, 0.99 * QUADROS)
+        self.assertEqual(falsos_fec, 0)
+        self.assertEqual(falsos, 0)
+
+    def test_delimitador_no_sorteio(self):
+        # Um delimitador corrompido emenda o quadro no seguinte, e isso o
+        # FEC não desfaz: a borda de 10 bytes perde ~1/10 a mais
+        certos, falsos = injetar(True, 1, delimitador=True)
+        print(f"\n1 byte errado contando o delimitador: {100 * certos / QUADROS:.1f}% certos com FEC")
+        self.assertGreater(certos, 0.88 * QUADROS)
+        # O quadro emendado só passa se o CRC-8 falhar (1 em 256), o mesmo
+        # piso que sem FEC
+        self.assertLess(falsos, QUADROS / 1000)
+
+    def test_dois_bytes_errados(self):
+        # Além do que o FEC corrige. Quando o decodificador ainda tentava
+        # o quadro no formato original, o CRC-8 tinha uma segunda chance de
+        # falhar: ~28 quadros falsos em 20000; agora nenhum ou quase
+        _, falsos = injetar(True, 2)
+        print(f"\n2 bytes errados: {falsos} de {QUADROS} aceitos errados com FEC")
+        self.assertLess(falsos, QUADROS / 2000)
+
+    def test_so_hello_sem_paridade(self):
+        dec = FrameDecoder()
+        dec.fec = True
+        dec.feed(b'\x00')
+        hello = bytes(HELLO.pack(0, CODE_HELLO, 1, 7, 1, 10, 25, 6, 3, 0))
+        borda = EVENT.pack(1, 3, 1)
+        # Depois de um reinício o dispositivo fala o formato original
+        self.assertEqual(dec.feed(encode_frame(borda)), [])
+        self.assertEqual(dec.feed(encode_frame(hello)), [hello])
+        self.assertEqual(dec.feed(encode_frame_fec(borda)), [borda])
+        self.assertEqual(dec.quadros_ruins, 1)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,141 @@
+#include <string.h>
+#include "check.h"
+#include "protocol.h"
+
+#define FUZZ_ROUNDS 20000
+
+static void random_payload(uint8_t *buf, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        // Plenty of zeros, since those are what COBS has to move around
+        uint32_t r = check_rand();
+        buf[i] = (r & 3) == 0 ? 0x00 : (uint8_t)(r >> 8);
+    }
+}
+
+// Poly 0x07, init 0xFF: the catalogue check string and the empty message
+static void test_crc8(void) {
+    CHECK(proto_crc8((const uint8_t *)"123456789", 9) == 0xFB);
+    CHECK(proto_crc8(NULL, 0) == 0xFF);
+}
+
+static void test_cobs_known(void) {
+    static const uint8_t zero[] = {0x00};
+    static const uint8_t mixed[] = {0x11, 0x22, 0x00, 0x33};
+    uint8_t out[8];
+
+    CHECK(proto_cobs_encode(zero, 1, out) == 2);
+    CHECK(out[0] == 0x01 && out[1] == 0x01);
+
+    CHECK(proto_cobs_encode(mixed, 4, out) == 5);
+    CHECK(memcmp(out, (const uint8_t[]){0x03, 0x11, 0x22, 0x02, 0x33}, 5) == 0);
+}
+
+// A 254-byte run without zeros needs the 0xFF block code
+static void test_cobs_long_run(void) {
+    uint8_t src[300], enc[310], dec[310];
+
+    for (size_t i = 0; i < sizeof(src); i++)
+        src[i] = (uint8_t)(i % 255) + 1;
+    size_t n = proto_cobs_encode(src, sizeof(src), enc);
+    CHECK(enc[0] == 0xFF);
+    CHECK(memchr(enc, 0x00, n) == NULL);
+    CHECK(proto_cobs_decode(enc, n, dec) == sizeof(src));
+    CHECK(memcmp(src, dec, sizeof(src)) == 0);
+}
+
+// Every payload survives encode/decode, and the only 0x00 in a frame is
+// the delimiter at the end
+static void test_frame_roundtrip(void) {
+    uint8_t payload[PROTO_MAX_PAYLOAD], frame[PROTO_MAX_FRAME], out[PROTO_MAX_PAYLOAD];
+
+    for (int round = 0; round < FUZZ_ROUNDS; round++) {
+        size_t len = 1 + check_rand() % PROTO_MAX_PAYLOAD;
+        random_payload(payload, len);
+
+        size_t n = proto_encode_frame(payload, len, frame);
+        CHECK(n >= len + 3 && n <= PROTO_MAX_FRAME);
+        CHECK(frame[n - 1] == PROTO_DELIMITER);
+        CHECK(memchr(frame, PROTO_DELIMITER, n - 1) == NULL);
+
+        CHECK(proto_decode_frame(frame, n - 1, out) == len);
+        CHECK(memcmp(payload, out, len) == 0);
+    }
+
+    CHECK(proto_encode_frame(payload, PROTO_MAX_PAYLOAD + 1, frame) == 0);
+}
+
+// Garbage must never decode past the payload buffer; the sanitizers
+// catch any out-of-bounds access
+static void test_decode_garbage(void) {
+    uint8_t junk[PROTO_MAX_FRAME + 8], out[PROTO_MAX_PAYLOAD];
+    int accepted = 0;
+
+    for (int round = 0; round < FUZZ_ROUNDS; round++) {
+        size_t len = check_rand() % sizeof(junk);
+        for (size_t i = 0; i < len; i++)
+            junk[i] = (uint8_t)check_rand();
+
+        size_t n = proto_decode_frame(junk, len, out);
+        CHECK(n <= PROTO_MAX_PAYLOAD);
+        if (n)
+            accepted++;
+    }
+    // Whatever gets through has to pass both COBS and the CRC: about 1/256
+    CHECK(accepted < FUZZ_ROUNDS / 100);
+}
+
+// CRC-8 with 0x07 catches every single-bit error in payload + CRC. After
+// COBS a flipped code byte can also move a zero, which the CRC still sees
+// unless it happens to match by chance.
+static void test_fault_injection(void) {
+    uint8_t payload[PROTO_MAX_PAYLOAD], frame[PROTO_MAX_FRAME], out[PROTO_MAX_PAYLOAD];
+    int injected = 0, missed = 0;
+
+    for (int round = 0; round < FUZZ_ROUNDS; round++) {
+        size_t len = 1 + check_rand() % PROTO_MAX_PAYLOAD;
+        random_payload(payload, len);
+        size_t n = proto_encode_frame(payload, len, frame) - 1;
+
+        size_t pos = check_rand() % n;
+        uint8_t flip = (uint8_t)(1u << (check_rand() % 8));
+        if ((frame[pos] ^ flip) == PROTO_DELIMITER)
+            continue;  // would split the frame, the receiver resyncs on it
+        frame[pos] ^= flip;
+        injected++;
+
+        size_t got = proto_decode_frame(frame, n, out);
+        if (got == len && memcmp(payload, out, len) == 0)
+            CHECK(!"corrupted frame decoded to the original payload");
+        else if (got)
+            missed++;
+    }
+    CHECK(injected > FUZZ_ROUNDS / 2);
+    CHECK(missed * 100 < injected);
+    printf("fault injection: %d single-bit errors, %d undetected\n", injected, missed);
+}
+
+// Same vectors as tests/test_fec_host.py, so both sides agree on the
+// parity bytes
+static void test_fec_known(void) {
+    static const uint8_t edge[] = {0x12, 0x05, 0x00, 0x01};
+    static const uint8_t zeros[] = {0x00, 0x00, 0x00, 0xFF, 0xFF};
+    uint8_t out[PROTO_MAX_FRAME_FEC];
+
+    CHECK(proto_encode_frame_fec(edge, sizeof(edge), out) == 10);
+    CHECK(memcmp(out, (const uint8_t[]){0x03, 0x12, 0x05, 0x03, 0x01, 0x5d,
+                                        0x03, 0x4b, 0x54, 0x00}, 10) == 0);
+    CHECK(proto_encode_frame_fec(zeros, sizeof(zeros), out) == 11);
+    CHECK(memcmp(out, (const uint8_t[]){0x01, 0x01, 0x01, 0x04, 0xff, 0xff, 0x1d,
+                                        0x03, 0x18, 0xe9, 0x00}, 11) == 0);
+}
+
+int main(void) {
+    test_crc8();
+    test_cobs_known();
+    test_cobs_long_run();
+    test_frame_roundtrip();
+    test_decode_garbage();
+    test_fault_injection();
+    test_fec_known();
+    return check_result("test_framing");
+}
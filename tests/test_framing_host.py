@@ -0,0 +1,99 @@
+"""Enquadramento do lado do host (python/protocol.py): ida e volta,
+ressincronização e injeção de falhas no fluxo de bytes."""
+
+import random
+import unittest
+
+from protocol import (FrameDecoder, cobs_decode, cobs_encode, crc8,
+                      encode_frame)
+
+RODADAS = 5000
+
+
+def payload_aleatorio(rng):
+    return bytes(0 if rng.random() < 0.25 else rng.randrange(256)
+                 for _ in range(rng.randint(1, 32)))
+
+
+class TestEnquadramento(unittest.TestCase):
+    def test_crc8(self):
+        # Mesmo valor de verificação usado em tests/test_framing.c
+        self.assertEqual(crc8(b"123456789"), 0xFB)
+
+    def test_cobs_ida_e_volta(self):
+        rng = random.Random(1)
+        for _ in range(RODADAS):
+            dados = payload_aleatorio(rng)
+            bloco = cobs_encode(dados)
+            self.assertNotIn(0, bloco)
+            self.assertEqual(cobs_decode(bloco), dados)
+
+    def test_cobs_bloco_longo(self):
+        dados = bytes(i % 255 + 1 for i in range(300))
+        bloco = cobs_encode(dados)
+        self.assertEqual(bloco[0], 0xFF)
+        self.assertEqual(cobs_decode(bloco), dados)
+
+    def test_comeca_no_meio_de_um_quadro(self):
+        dec = FrameDecoder()
+        quadro = encode_frame(b"\x01\x02\x03")
+        self.assertEqual(dec.feed(quadro[2:] + quadro), [b"\x01\x02\x03"])
+        self.assertEqual(dec.quadros_ruins, 0)
+
+    def test_fluxo_com_falhas(self):
+        """Bytes perdidos, trocados ou inseridos custam só o quadro afetado."""
+        rng = random.Random(2)
+        dec = FrameDecoder()
+        dec.feed(b"\x00")
+        enviados = entregues = falsos = 0
+        for _ in range(RODADAS):
+            payload = payload_aleatorio(rng)
+            quadro = bytearray(encode_frame(payload))
+            falha = rng.random()
+            if falha < 0.1:
+                del quadro[rng.randrange(len(quadro) - 1)]
+            elif falha < 0.2:
+                quadro[rng.randrange(len(quadro) - 1)] ^= 1 << rng.randrange(8)
+            elif falha < 0.3:
+                quadro.insert(rng.randrange(len(quadro)), rng.randrange(1, 256))
+            enviados += 1
+            for recebido in dec.feed(bytes(quadro)):
+                if recebido == payload:
+                    entregues += 1
+                else:
+                    falsos += 1
+        # Todo quadro intacto chega, e o CRC barra quase todo o resto
+        self.assertGreaterEqual(entregues, enviados * 0.7)
+        self.assertLess(falsos, enviados * 0.3 / 100)
+        self.assertGreater(dec.quadros_ruins, enviados * 0.25)
+
+    def test_buffers_reaproveitados(self):
+        """O quadro é montado e decodificado sempre nos mesmos buffers, e o
+        payload entregue não muda quando o próximo quadro chega."""
+        dec = FrameDecoder()
+        dec.feed(b"\x00")
+        buffers = (dec.buffer, dec._raw)
+        primeiro = dec.feed(encode_frame(b"\x01\x02\x03"))[0]
+        rng = random.Random(3)
+        for _ in range(200):
+            payload = payload_aleatorio(rng)
+            quadro = encode_frame(payload)
+            # Em pedaços, como a serial entrega
+            corte = rng.randrange(len(quadro))
+            recebidos = dec.feed(quadro[:corte]) + dec.feed(quadro[corte:])
+            self.assertEqual(recebidos, [payload])
+        self.assertIs(dec.buffer, buffers[0])
+        self.assertIs(dec._raw, buffers[1])
+        self.assertEqual(len(dec.buffer), FrameDecoder.MAX_QUADRO)
+        self.assertEqual(primeiro, b"\x01\x02\x03")
+
+    def test_quadro_grande_demais(self):
+        dec = FrameDecoder()
+        dec.feed(b"\x00")
+        self.assertEqual(dec.feed(b"\x01" * 100 + b"\x00"), [])
+        self.assertEqual(dec.quadros_ruins, 1)
+        self.assertEqual(dec.feed(encode_frame(b"\x07\x08")), [b"\x07\x08"])
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,187 @@
+#include <stddef.h>
+#include <string.h>
+#include "check.h"
+#include "common.h"
+#include "hid_report.h"
+
+static const uint8_t desc[] = {HID_REPORT_DESC};
+
+// One input field as the host's HID parser sees it
+typedef struct {
+    uint16_t page, usage;
+    int bit, size;
+    int32_t min, max;
+    uint8_t flags;
+} field_t;
+
+static field_t fields[64];
+static int field_count;
+
+static int32_t item_value(const uint8_t *p, int size, bool is_signed) {
+    uint32_t v = 0;
+    for (int i = 0; i < size; i++)
+        v |= (uint32_t)p[i] << (8 * i);
+    if (is_signed && size > 0 && size < 4 && (v >> (8 * size - 1)))
+        v |= ~0u << (8 * size);
+    return (int32_t)v;
+}
+
+// Walks the short items of the descriptor and lays out every Input
+// field; returns the report length in bits, -1 on a malformed descriptor
+static int parse_descriptor(void) {
+    uint16_t page = 0, usages[32];
+    int usage_count = 0, usage_min = -1, usage_max = -1;
+    int report_size = 0, report_count = 0, bit = 0, depth = 0;
+    int32_t min = 0, max = 0;
+
+    field_count = 0;
+    for (size_t i = 0; i < sizeof(desc);) {
+        uint8_t prefix = desc[i];
+        int size = (prefix & 3) == 3 ? 4 : prefix & 3;
+        uint8_t item = prefix & 0xFC;
+        if (i + 1 + size > sizeof(desc))
+            return -1;
+        int32_t u = item_value(&desc[i + 1], size, false);
+        int32_t s = item_value(&desc[i + 1], size, true);
+        i += 1 + size;
+
+        switch (item) {
+        case 0x04: page = u; break;              // Usage Page
+        case 0x14: min = s; break;               // Logical Minimum
+        case 0x24: max = s; break;               // Logical Maximum
+        case 0x74: report_size = u; break;       // Report Size
+        case 0x94: report_count = u; break;      // Report Count
+        case 0x34: case 0x44: break;             // Physical Min/Max
+        case 0x08: usages[usage_count++] = u; break;  // Usage
+        case 0x18: usage_min = u; break;         // Usage Minimum
+        case 0x28: usage_max = u; break;         // Usage Maximum
+        case 0xA0: depth++; usage_count = 0; break;   // Collection
+        case 0xC0: depth--; break;               // End Collection
+        case 0x80:                               // Input
+            if (field_count + report_count > 64)
+                return -1;
+            for (int k = 0; k < report_count; k++) {
+                field_t *f = &fields[field_count++];
+                f->page = page;
+                if (usage_min >= 0)
+                    f->usage = usage_min + k <= usage_max ? usage_min + k : usage_max;
+                else
+                    f->usage = usages[k < usage_count ? k : usage_count - 1];
+                f->bit = bit;
+                f->size = report_size;
+                f->min = min;
+                f->max = max;
+                f->flags = u;
+                bit += report_size;
+            }
+            usage_count = 0;
+            usage_min = usage_max = -1;
+            break;
+        default:
+            return -1;
+        }
+        if (depth < 0 || usage_count >= 32)
+            return -1;
+    }
+    return depth == 0 ? bit : -1;
+}
+
+static const field_t *find(uint16_t page, uint16_t usage) {
+    for (int i = 0; i < field_count; i++)
+        if (fields[i].page == page && fields[i].usage == usage)
+            return &fields[i];
+    return NULL;
+}
+
+static void check_axis(uint16_t usage, size_t offset) {
+    const field_t *f = find(0x01, usage);
+    CHECK(f != NULL);
+    if (!f)
+        return;
+    CHECK(f->bit == (int)offset * 8 && f->size == 8);
+    CHECK(f->min == -127 && f->max == 127);
+}
+
+// The descriptor describes hid_report_t byte for byte, or the host
+// reads the axes and buttons from the wrong place
+static void test_descriptor(void) {
+    CHECK(parse_descriptor() == (int)sizeof(hid_report_t) * 8);
+    CHECK(sizeof(hid_report_t) == 11);
+
+    check_axis(0x30, offsetof(hid_report_t, x));
+    check_axis(0x31, offsetof(hid_report_t, y));
+    check_axis(0x32, offsetof(hid_report_t, z));
+    check_axis(0x35, offsetof(hid_report_t, rz));
+    check_axis(0x33, offsetof(hid_report_t, rx));
+    check_axis(0x34, offsetof(hid_report_t, ry));
+
+    // 0 (centered) is outside 1-8, so the null state flag must be set
+    const field_t *hat = find(0x01, 0x39);
+    CHECK(hat && hat->bit == (int)offsetof(hid_report_t, hat) * 8 && hat->size == 8);
+    CHECK(hat && hat->min == 1 && hat->max == 8 && (hat->flags & 0x40));
+
+    for (int n = 1; n <= 32; n++) {
+        const field_t *b = find(0x09, n);
+        CHECK(b && b->size == 1 && b->min == 0 && b->max == 1);
+        CHECK(b && b->bit == (int)offsetof(hid_report_t, buttons) * 8 + n - 1);
+    }
+}
+
+// Reads a field out of the report bytes the way the host does
+static int32_t read_field(const hid_report_t *report, const field_t *f) {
+    const uint8_t *bytes = (const uint8_t *)report;
+    uint32_t v = 0;
+    for (int i = 0; i < f->size; i++)
+        v |= (uint32_t)((bytes[(f->bit + i) / 8] >> ((f->bit + i) % 8)) & 1) << i;
+    return f->min < 0 ? item_value((const uint8_t *)&v, f->size / 8, true) : (int32_t)v;
+}
+
+static void test_pack(void) {
+    hid_report_t report;
+    input_state_t st = {0};
+
+    parse_descriptor();
+
+    // Edge code n is HID button n
+    for (int code = 1; code <= 15; code++) {
+        st.pressed = 1u << code;
+        st.pot = 128;
+        hid_pack_report(&st, &report);
+        for (int n = 1; n <= 32; n++)
+            CHECK(read_field(&report, find(0x09, n)) == (n == code));
+    }
+
+    // FSR level drives Z, the strongest pressed level wins
+    static const struct { uint16_t pressed; int8_t z; } fsr[] = {
+        {0, -127},
+        {1u << AXIS_FSR, -42},
+        {1u << (AXIS_FSR + 1), 42},
+        {(1u << AXIS_FSR) | (1u << (AXIS_FSR + 2)), 127},
+    };
+    for (size_t i = 0; i < sizeof(fsr) / sizeof(fsr[0]); i++) {
+        st.pressed = fsr[i].pressed;
+        hid_pack_report(&st, &report);
+        CHECK(read_field(&report, find(0x01, 0x32)) == fsr[i].z);
+    }
+
+    // Pot 0-255 maps to Rx, clamped to the logical range
+    static const struct { int16_t pot; int8_t rx; } pot[] = {
+        {0, -127}, {1, -127}, {128, 0}, {200, 72}, {255, 127}, {-500, -127}, {4095, 127},
+    };
+    st.pressed = 0;
+    for (size_t i = 0; i < sizeof(pot) / sizeof(pot[0]); i++) {
+        st.pot = pot[i].pot;
+        hid_pack_report(&st, &report);
+        CHECK(read_field(&report, find(0x01, 0x33)) == pot[i].rx);
+    }
+
+    // Everything else rests centered
+    CHECK(report.x == 0 && report.y == 0 && report.rz == 0 && report.ry == 0);
+    CHECK(report.hat == 0);
+}
+
+int main(void) {
+    test_descriptor();
+    test_pack();
+    return check_result("test_hid_report");
+}
@@ -0,0 +1,101 @@
+"""Janela de lote num link empacotado, como o do HC-06: o módulo junta o
+que chegou pela UART e manda um pacote de rádio a cada intervalo de
+conexão. É a simulação por trás da tabela da seção "Janela de lote
+adaptativa" do README."""
+
+import random
+import unittest
+
+from protocol import Pacotizacao
+
+INTERVALO = 0.015  # entre pacotes de rádio
+BYTE_UART = 10 / 115200  # 8N1
+BYTES_BORDA = 7  # quadro de borda no fio
+ACORDES = 4000
+
+
+def acordes(rng):
+    """Instantes das bordas: acordes de 1 a 4 botões, com os toques de um
+    acorde espalhados por até 8 ms e ~150 ms entre acordes."""
+    t = 0.0
+    bordas = []
+    for _ in range(ACORDES):
+        t += 0.02 + rng.expovariate(1 / 0.13)
+        bordas += sorted(t + rng.uniform(0, 0.008) for _ in range(rng.randint(1, 4)))
+    return bordas
+
+
+def escritas(bordas, janela):
+    """Quando cada borda vai para a UART. A primeira de um lote abre a
+    janela; tudo que chega até ela fechar sai junto."""
+    saida = []
+    fecha = None
+    for t in bordas:
+        if janela == 0:
+            saida.append(t)
+            continue
+        if fecha is None or t > fecha:
+            fecha = t + janela
+        saida.append(fecha)
+    return saida
+
+
+def simular(janela, semente=3):
+    """Devolve latência média, pior latência e bordas por pacote."""
+    rng = random.Random(semente)
+    bordas = acordes(rng)
+    fase = rng.uniform(0, INTERVALO)
+    latencias = []
+    pacotes = set()
+    uart_livre = 0.0
+    for t, escrita in zip(bordas, escritas(bordas, janela)):
+        # A UART serializa os bytes; o pacote leva o que chegou inteiro
+        uart_livre = max(uart_livre, escrita) + BYTES_BORDA * BYTE_UART
+        n = int((uart_livre - fase) // INTERVALO) + 1
+        chegada = fase + n * INTERVALO
+        latencias.append(chegada - t)
+        pacotes.add(n)
+    return (sum(latencias) / len(latencias), max(latencias), len(bordas) / len(pacotes))
+
+
+class TestPacotes(unittest.TestCase):
+    def test_janela_nao_compensa_no_link_tranquilo(self):
+        janelas = (0.0, INTERVALO / 4, INTERVALO / 2)
+        resultados = [simular(j) for j in janelas]
+        print()
+        print("| Janela | Latência média | Pior | Bordas por pacote |")
+        for j, (media, pior, por_pacote) in zip(janelas, resultados):
+            print(f"| {j * 1000:.2f} ms | {media * 1000:.1f} ms | "
+                  f"{pior * 1000:.1f} ms | {por_pacote:.2f} |")
+
+        (m0, p0, b0), (m1, p1, b1), (m2, p2, b2) = resultados
+        # Sem janela, a espera é só a fase do pacote: meio intervalo em média
+        self.assertAlmostEqual(m0, INTERVALO / 2, delta=0.002)
+        self.assertLessEqual(p0, INTERVALO + 0.002)
+        # Cada janela soma quase ela inteira à latência...
+        self.assertGreater(m1 - m0, 0.6 * INTERVALO / 4)
+        self.assertGreater(m2 - m0, 0.6 * INTERVALO / 2)
+        # ...e junta pouco: o módulo já agrupa o que sai perto
+        self.assertLess(b2 / b0, 1.2)
+        self.assertGreater(b2, b0)
+
+    def test_estimativa_do_intervalo(self):
+        """Pacotizacao acha o intervalo de conexão nas rajadas que chegam
+        ao host, mesmo com pacotes vazios e atraso na leitura."""
+        rng = random.Random(5)
+        estimador = Pacotizacao()
+        t = 1.0
+        for _ in range(200):
+            t += INTERVALO * rng.choice((1, 1, 1, 2, 3))
+            estimador.chegada(t + rng.uniform(0, 0.0005))
+        self.assertAlmostEqual(estimador.intervalo_us(), INTERVALO * 1e6, delta=600)
+
+    def test_estimativa_ignora_link_parado(self):
+        estimador = Pacotizacao()
+        for k in range(20):
+            estimador.chegada(k * 0.5)
+        self.assertEqual(estimador.intervalo_us(), 0)
+
+
+if __name__ == '__main__':
+    unittest.main()
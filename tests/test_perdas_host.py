@@ -0,0 +1,174 @@
+"""Link com perdas: reenvios atrasados não podem prender teclas no host.
+
+O FirmwareSimulado segue a hc06_task: bordas com seq, janela de 8 bordas
+sem ACK, reenvio com o seq original depois de 100 ms (até 4 vezes) e
+heartbeat quando parado, quadro de estado periódico, no pedido de RESYNC e quando uma borda esgota
+as tentativas. As bordas vão pela fila rápida e os quadros de estado pela
+fila comum, então uma borda pode passar na frente de um estado mais velho.
+"""
+
+import contextlib
+import io
+import random
+import unittest
+
+import protocol
+from link_simulado import FimSimulacao, LinkSimulado, importar_main
+
+main, teclado = importar_main()
+
+CODIGOS = {0x01: 'w', 0x02: 's', 0x03: 'd', 0x04: 'a'}
+RETX_TIMEOUT = 0.1
+RETX_TENTATIVAS = 4
+JANELA = 8
+# Com o link ocupado a hc06_task espaça os quadros de estado até 2 s
+INTERVALO_ESTADO = 2.0
+# Pior caso legítimo para o host acompanhar uma borda: todas as tentativas
+TOLERANCIA = RETX_TIMEOUT * (RETX_TENTATIVAS + 1) + 0.1
+
+
+class FirmwareSimulado:
+    def __init__(self, link, rng, perda):
+        self.link = link
+        self.rng = rng
+        self.perda = perda
+        self.seq = 0
+        self.pressionados = set()
+        self.mudou_em = {c: 0.0 for c in CODIGOS}
+        self.pendentes = {}  # seq -> [payload, enviado_em, tentativas]
+        self.proximo_estado = INTERVALO_ESTADO
+        self.proximo_evento = 0.2
+        self.reenvios = 0
+        self.ultimo_envio = 0.0
+
+    def _transmitir(self, t, payload, seq, atraso):
+        self.ultimo_envio = t
+        if self.rng.random() >= self.perda:
+            self.link.enviar(t + atraso, payload, seq)
+
+    def _novo_seq(self):
+        seq = self.seq
+        self.seq = (self.seq + 1) & 0xFF
+        return seq
+
+    def borda(self, t, codigo, apertar):
+        seq = self._novo_seq()
+        payload = protocol.EVENT.pack(seq, codigo | (0 if apertar else 0x80), 1)
+        if len(self.pendentes) >= JANELA:
+            del self.pendentes[min(self.pendentes, key=lambda s: self.pendentes[s][1])]
+            self.estado(t)
+        self.pendentes[seq] = [payload, t, 0]
+        self._transmitir(t, payload, seq, self.rng.uniform(0.005, 0.015))
+
+    def estado(self, t):
+        seq = self._novo_seq()
+        mascara = sum(1 << c for c in self.pressionados)
+        payload = protocol.STATE.pack(seq, protocol.CODE_STATE, mascara, 0, 0)
+        # Fila comum: sai atrás do que já estava na UART
+        self._transmitir(t, payload, seq, self.rng.uniform(0.02, 0.06))
+
+    def passo(self, t):
+        if t >= self.proximo_evento and t < self.link.fim - 1.0:
+            codigo = self.rng.choice(list(CODIGOS))
+            apertar = codigo not in self.pressionados
+            if apertar:
+                self.pressionados.add(codigo)
+            else:
+                self.pressionados.discard(codigo)
+            self.mudou_em[codigo] = t
+            self.borda(t, codigo, apertar)
+            self.proximo_evento = t + self.rng.uniform(0.01, 0.08)
+
+        for seq, pendente in list(self.pendentes.items()):
+            payload, enviado, tentativas = pendente
+            if t - enviado < RETX_TIMEOUT:
+                continue
+            if tentativas >= RETX_TENTATIVAS:
+                del self.pendentes[seq]
+                self.estado(t)
+                continue
+            pendente[1] = t
+            pendente[2] += 1
+            self.reenvios += 1
+            self._transmitir(t, payload, seq, self.rng.uniform(0.005, 0.015))
+
+        if t >= self.proximo_estado:
+            self.proximo_estado = t + INTERVALO_ESTADO
+            self.estado(t)
+        if t - self.ultimo_envio >= 0.25:
+            self._transmitir(t, protocol.HEARTBEAT.pack(0, protocol.CODE_HEARTBEAT),
+                             self._novo_seq(), 0.005)
+
+    def ao_receber(self, t, payload):
+        if self.rng.random() < self.perda:
+            return
+        if payload[0] == protocol.CMD_ACK and len(payload) == 3:
+            _, seq, mascara = payload
+            for s in list(self.pendentes):
+                d = (seq - s) & 0xFF
+                if d == 0 or (d <= 8 and mascara & (1 << (d - 1))):
+                    del self.pendentes[s]
+        elif payload[0] == protocol.CMD_RESYNC:
+            self.estado(t)
+
+
+def simular(semente, perda, duracao=20.0):
+    """Roda controle() contra o firmware simulado e mede teclas presas.
+
+    Uma tecla está presa quando o host a segura (ou solta) ao contrário do
+    dispositivo por mais que TOLERANCIA desde a última mudança dela.
+    """
+    teclado.pressionadas.clear()
+    teclado.historico.clear()
+    link = LinkSimulado(main, teclado, fim=duracao)
+    rng = random.Random(semente)
+    firmware = FirmwareSimulado(link, rng, perda)
+    presas = []
+
+    def passo(t):
+        firmware.passo(t)
+        for codigo, tecla in CODIGOS.items():
+            errado = (tecla in teclado.pressionadas) != (codigo in firmware.pressionados)
+            if errado and t - firmware.mudou_em[codigo] > TOLERANCIA:
+                presas.append((t, tecla))
+
+    link.a_cada_passo = passo
+    link.ao_receber = firmware.ao_receber
+    with contextlib.redirect_stdout(io.StringIO()):
+        try:
+            main.controle(link, timeout_link=1.0)
+        except FimSimulacao:
+            pass
+    return presas, firmware
+
+
+class TestPerdas(unittest.TestCase):
+    def test_link_limpo(self):
+        presas, firmware = simular(1, 0.0, duracao=5.0)
+        self.assertEqual(presas, [])
+        self.assertEqual(firmware.reenvios, 0)
+
+    def test_link_com_perdas(self):
+        for semente in range(5):
+            presas, firmware = simular(semente, 0.2)
+            self.assertGreater(firmware.reenvios, 50)
+            self.assertEqual(presas, [], f"semente {semente}: {presas[:3]}")
+
+    def test_ordem_bordas(self):
+        ordem = protocol.OrdemBordas()
+        ordem.avancar(10)
+        self.assertTrue(ordem.aceitar(1, 10))   # soltou
+        ordem.avancar(11)
+        self.assertFalse(ordem.aceitar(1, 9))   # aperto reenviado, mais velho
+        # Estado mais velho que a borda não vale para o código 1
+        self.assertEqual(ordem.estado(8, {1, 2}), {2})
+        self.assertTrue(ordem.aceitar(1, 12))
+        # Registros fora da janela são esquecidos, sem ambiguidade na volta
+        for seq in range(12, 12 + 200):
+            ordem.avancar(seq & 0xFF)
+        self.assertTrue(ordem.aceitar(1, (12 + 200) & 0xFF))
+        self.assertTrue(ordem.aceitar(2, (12 + 201) & 0xFF))
+
+
+if __name__ == '__main__':
+    unittest.main()
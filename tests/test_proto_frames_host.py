@@ -0,0 +1,68 @@
+"""Ida e volta dos layouts gerados por protocol/gerar.py: o firmware
+empacota cada quadro com proto_pack_*() (tests/proto_frames_roundtrip.c) e
+os struct.Struct de python/proto_frames.py têm que ler os mesmos valores.
+Confere também que os arquivos gerados estão em dia com o schema."""
+
+import json
+import os
+import subprocess
+import sys
+import unittest
+
+import proto_frames
+
+RAIZ = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+sys.path.insert(0, os.path.join(RAIZ, 'protocol'))
+import gerar  # noqa: E402
+
+PROGRAMA = os.environ.get('PROTO_ROUNDTRIP')
+
+
+def saida_do_firmware():
+    saida = subprocess.run([PROGRAMA], check=True, capture_output=True, text=True).stdout
+    return [linha.split() for linha in saida.splitlines()]
+
+
+class TestQuadrosGerados(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        with open(gerar.SCHEMA, encoding='utf-8') as f:
+            cls.schema = json.load(f)
+        cls.linhas = {campos[0]: campos[1:] for campos in saida_do_firmware()}
+
+    def test_quadros_c_para_python(self):
+        for quadro in self.schema['frames']:
+            nome = quadro['name']
+            with self.subTest(quadro=nome):
+                *valores, hexa = self.linhas[nome]
+                dados = bytes.fromhex(hexa)
+                estrutura = getattr(proto_frames, nome.upper())
+                self.assertEqual(estrutura.size, len(dados))
+                self.assertEqual(estrutura.unpack(dados), tuple(int(v) for v in valores))
+                # E de volta: o Python empacota os mesmos bytes
+                self.assertEqual(estrutura.pack(*(int(v) for v in valores)), dados)
+
+    def test_tamanho_dos_comandos(self):
+        for cmd in self.schema['commands']:
+            nome = cmd['name']
+            with self.subTest(comando=nome):
+                estrutura = getattr(proto_frames, f"CMD_{nome.upper()}_STRUCT")
+                self.assertEqual(estrutura.size, int(self.linhas['cmd_' + nome][0]))
+
+    def test_constantes(self):
+        for grupo in self.schema['constants']:
+            for nome in grupo['values']:
+                chave = f"{grupo['group']}_{nome}"
+                self.assertEqual(getattr(proto_frames, chave), int(self.linhas[chave][0]), chave)
+
+    def test_gerados_em_dia(self):
+        for caminho, gerador in ((gerar.SAIDA_C, gerar.gerar_c), (gerar.SAIDA_PY, gerar.gerar_py),
+                                 (gerar.SAIDA_TESTE, gerar.gerar_teste)):
+            with self.subTest(arquivo=os.path.relpath(caminho, RAIZ)):
+                with open(caminho, encoding='utf-8') as f:
+                    self.assertEqual(f.read(), gerador(self.schema),
+                                     "rode python3 protocol/gerar.py")
+
+
+if __name__ == '__main__':
+    unittest.main()
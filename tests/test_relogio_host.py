@@ -0,0 +1,105 @@
+"""Sincronia de relógio (python/protocol.py, RelogioDispositivo) sobre um
+link simulado com atraso assimétrico: ida curta, volta longa e com
+rajadas, como no HC-06, que junta os bytes em pacotes antes de enviar."""
+
+import random
+import unittest
+
+from protocol import RelogioDispositivo
+
+VOLTA_32 = 1 << 32
+
+
+class Dispositivo:
+    """Relógio do dispositivo: deriva em ppm, começando perto da volta do
+    contador de 32 bits para o teste passar por ela."""
+
+    def __init__(self, deriva_ppm, inicio_us=VOLTA_32 - 20_000_000):
+        self.deriva = deriva_ppm * 1e-6
+        self.inicio_us = inicio_us
+
+    def us(self, t_host):
+        return int(self.inicio_us + t_host * (1 + self.deriva) * 1e6) % VOLTA_32
+
+
+class Link:
+    """Atraso de cada sentido: base + exponencial, com rajadas ocasionais
+    (retransmissão do Bluetooth) só na volta."""
+
+    def __init__(self, rng, ida, volta, jitter=0.001, rajada=0.0):
+        self.rng, self.ida, self.volta = rng, ida, volta
+        self.jitter, self.rajada = jitter, rajada
+
+    def atraso_ida(self):
+        return self.ida + self.rng.expovariate(1 / self.jitter)
+
+    def atraso_volta(self):
+        extra = 0.05 if self.rng.random() < self.rajada else 0.0
+        return self.volta + self.rng.expovariate(1 / self.jitter) + extra
+
+
+def sincronizar(relogio, dispositivo, link, rng, trocas=120, intervalo=1.0, t0=1000.0):
+    """Uma troca CMD_TIME/CODE_TIME por intervalo; devolve o fim, no relógio do host."""
+    t = t0
+    for _ in range(trocas):
+        t1 = t
+        t2 = t1 + link.atraso_ida()
+        t3 = t2 + rng.uniform(0.0005, 0.003)  # command_task -> hc06_task
+        t4 = t3 + link.atraso_volta()
+        relogio.adicionar(t1, dispositivo.us(t2 - t0), dispositivo.us(t3 - t0), t4)
+        t += intervalo
+    return t
+
+
+class TestRelogio(unittest.TestCase):
+    def verificar(self, ida, volta, deriva_ppm, rajada=0.0, semente=1):
+        rng = random.Random(semente)
+        dispositivo = Dispositivo(deriva_ppm)
+        link = Link(rng, ida, volta, rajada=rajada)
+        relogio = RelogioDispositivo()
+        t0 = 1000.0
+        fim = sincronizar(relogio, dispositivo, link, rng, t0=t0)
+
+        self.assertTrue(relogio.sincronizado())
+        # 16 amostras boas em 32 s com ~1 ms de jitter: a inclinação erra
+        # até ~15 ppm, menos de 0,5 ms ao longo da janela
+        self.assertAlmostEqual(relogio.deriva * 1e6, deriva_ppm, delta=20)
+        # O erro de cada conversão fica dentro da incerteza anunciada
+        for atras in (0.0, 5.0, 15.0):
+            h = fim - atras
+            erro = relogio.para_host(dispositivo.us(h - t0)) - h
+            self.assertLessEqual(abs(erro), relogio.incerteza, f"{atras} s atrás")
+        return relogio, dispositivo, t0, fim
+
+    def test_link_simetrico(self):
+        relogio, *_ = self.verificar(ida=0.008, volta=0.008, deriva_ppm=40)
+        self.assertLess(relogio.incerteza, 0.010)
+
+    def test_volta_mais_lenta(self):
+        # Metade da assimetria (6,5 ms) aparece como erro de offset, e a
+        # incerteza tem que cobrir isso
+        relogio, *_ = self.verificar(ida=0.002, volta=0.015, deriva_ppm=-25)
+        self.assertGreaterEqual(relogio.incerteza, (0.015 - 0.002) / 2)
+
+    def test_rajadas_na_volta(self):
+        # 20% das respostas atrasam mais 50 ms; o filtro de menor atraso
+        # descarta essas amostras
+        relogio, *_ = self.verificar(ida=0.002, volta=0.015, deriva_ppm=60, rajada=0.2)
+        self.assertLess(relogio.incerteza, 0.020)
+
+    def test_divisao_da_latencia(self):
+        """A parte "link" de uma borda, calculada como em main.py, erra no
+        máximo pela incerteza."""
+        rng = random.Random(7)
+        relogio, dispositivo, t0, fim = self.verificar(ida=0.002, volta=0.015, deriva_ppm=30)
+        for _ in range(100):
+            post = fim + rng.uniform(0, 10)
+            fila = rng.uniform(0, 0.004)
+            link = 0.015 + rng.expovariate(1 / 0.002)
+            t_rx = post + fila + link
+            estimado = t_rx - relogio.para_host(dispositivo.us(post - t0)) - fila
+            self.assertLessEqual(abs(estimado - link), relogio.incerteza + 1e-5)
+
+
+if __name__ == '__main__':
+    unittest.main()
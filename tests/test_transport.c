@@ -0,0 +1,273 @@
+#include <string.h>
+#include "check.h"
+#include "pico/stdlib.h"
+#include "transport.h"
+#include "tusb.h"
+
+#define FAKE_CAPACITY 64
+#define STREAM_FRAMES 2000
+
+// A link backed by a plain buffer, with the room and readiness the test
+// picks
+typedef struct {
+    bool ready;
+    size_t capacity;
+    uint8_t data[4096];
+    size_t len;
+    TickType_t poll_wait;
+} fake_link_t;
+
+static fake_link_t link_a, link_b;
+
+#define FAKE_OPS(l)                                                                   \
+    static TickType_t l##_poll(void) { return link_##l.poll_wait; }                   \
+    static bool l##_ready(void) { return link_##l.ready; }                            \
+    static size_t l##_room(transport_lane_t lane) {                                   \
+        (void)lane;                                                                   \
+        return link_##l.capacity - link_##l.len;                                      \
+    }                                                                                 \
+    static bool l##_write(transport_lane_t lane, const uint8_t *d, size_t n) {        \
+        if (l##_room(lane) < n)                                                       \
+            return false;                                                             \
+        memcpy(&link_##l.data[link_##l.len], d, n);                                   \
+        link_##l.len += n;                                                            \
+        return true;                                                                  \
+    }                                                                                 \
+    static size_t l##_pending(transport_lane_t lane) {                                \
+        (void)lane;                                                                   \
+        return link_##l.len;                                                          \
+    }                                                                                 \
+    static void l##_start(void) {}                                                    \
+    static transport_t transport_##l = {.start = l##_start, .poll = l##_poll,        \
+                                        .ready = l##_ready, .room = l##_room,         \
+                                        .write = l##_write, .pending = l##_pending};
+
+FAKE_OPS(a)
+FAKE_OPS(b)
+
+static TaskHandle_t usb_task_handle = NULL;
+
+// usb_hid.c is not part of this test; its wakeup goes to the fake USB task
+void usb_hid_wake(void) {
+    if (usb_task_handle != NULL)
+        xTaskNotifyGive(usb_task_handle);
+}
+
+static void test_fan_out(void) {
+    static const uint8_t frame[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 0};
+
+    transport_register(&transport_a);
+    transport_register(&transport_b);
+    transport_register(&transport_cdc);
+    transport_start_all();
+
+    link_a = (fake_link_t){.ready = false, .capacity = FAKE_CAPACITY, .poll_wait = 50};
+    link_b = (fake_link_t){.ready = false, .capacity = 2 * FAKE_CAPACITY, .poll_wait = 20};
+    CHECK(transport_poll_all() == 20);
+    CHECK(!transport_any_ready());
+    CHECK(transport_room(TRANSPORT_LANE_BULK) == 0);
+    CHECK(!transport_send(TRANSPORT_LANE_BULK, frame, sizeof(frame), 0));
+    CHECK(!transport_reconnected());
+
+    // The slowest ready link sets the room
+    link_a.ready = link_b.ready = true;
+    transport_poll_all();
+    CHECK(transport_reconnected());
+    CHECK(!transport_reconnected());
+    CHECK(transport_room(TRANSPORT_LANE_BULK) == FAKE_CAPACITY);
+
+    // Whatever fits in room reaches both links, so neither drops
+    fake_advance_us(1000);
+    uint32_t oldest = time_us_32();
+    fake_advance_us(300);
+    size_t sent = 0;
+    while (transport_room(TRANSPORT_LANE_BULK) >= sizeof(frame)) {
+        CHECK(transport_send(TRANSPORT_LANE_BULK, frame, sizeof(frame), oldest));
+        sent += sizeof(frame);
+    }
+    CHECK(link_a.len == sent && link_b.len == sent);
+    CHECK(memcmp(link_a.data, link_b.data, sent) == 0);
+    CHECK(transport_a.stats.drops == 0 && transport_b.stats.drops == 0);
+    CHECK(transport_a.stats.bytes == sent && transport_b.stats.frames == sent / sizeof(frame));
+    CHECK(transport_a.stats.latency_max_us == 300);
+
+    // Pending is the deepest backlog
+    link_a.len = 0;
+    CHECK(transport_pending(TRANSPORT_LANE_BULK) == sent);
+    CHECK(!transport_idle());
+
+    // A link that went down does not hold the others back, nor count drops
+    link_b.ready = false;
+    CHECK(transport_room(TRANSPORT_LANE_BULK) == FAKE_CAPACITY);
+    CHECK(transport_send(TRANSPORT_LANE_BULK, frame, sizeof(frame), 0));
+    CHECK(transport_b.stats.drops == 0);
+    CHECK(link_a.len == sizeof(frame));
+
+    // A write past room still fails on the full link alone
+    link_b.ready = true;
+    link_b.len = link_b.capacity;
+    CHECK(transport_send(TRANSPORT_LANE_BULK, frame, sizeof(frame), 0));
+    CHECK(transport_b.stats.drops == 1 && transport_a.stats.drops == 0);
+
+    link_a.ready = link_b.ready = false;
+}
+
+// A link that stops draining (a CDC port nobody reads) is skipped after
+// TRANSPORT_STALL_US instead of pacing the others down to nothing
+static void test_stall(void) {
+    static const uint8_t frame[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 0};
+
+    link_a = (fake_link_t){.ready = true, .capacity = FAKE_CAPACITY, .poll_wait = 50};
+    link_b = (fake_link_t){.ready = true, .capacity = FAKE_CAPACITY, .poll_wait = 50};
+    transport_poll_all();
+    transport_reconnected();
+    uint32_t drops = transport_b.stats.drops;
+
+    // a drains as fast as it is written, b never does
+    while (transport_room(TRANSPORT_LANE_BULK) >= sizeof(frame)) {
+        CHECK(transport_send(TRANSPORT_LANE_BULK, frame, sizeof(frame), 0));
+        link_a.len = 0;
+    }
+    fake_advance_us(400000);
+    transport_poll_all();
+    CHECK(transport_room(TRANSPORT_LANE_BULK) < sizeof(frame));
+
+    fake_advance_us(100000);
+    transport_poll_all();
+    CHECK(transport_room(TRANSPORT_LANE_BULK) == FAKE_CAPACITY);
+    CHECK(transport_send(TRANSPORT_LANE_EDGE, frame, sizeof(frame), 0));
+    CHECK(link_a.len == sizeof(frame));
+    CHECK(transport_b.stats.drops == drops);
+    CHECK(transport_pending(TRANSPORT_LANE_BULK) == sizeof(frame));
+    CHECK(transport_any_ready());
+    CHECK(!transport_reconnected());
+
+    // Once it drains it is back, as a reconnect, so it gets a fresh state
+    link_b.len -= sizeof(frame);
+    transport_poll_all();
+    CHECK(transport_reconnected());
+    CHECK(transport_room(TRANSPORT_LANE_BULK) == FAKE_CAPACITY - link_b.len);
+
+    link_a.ready = link_b.ready = false;
+    transport_poll_all();
+}
+
+// Bytes written to transport_cdc only reach TinyUSB through
+// transport_cdc_service(), and the host's bytes come back the same way
+static void test_cdc_buffers(void) {
+    uint8_t buf[512];
+    uint8_t frame[40];
+
+    transport_cdc_service();
+    CHECK(!transport_cdc.ready());
+
+    fake_cdc_set_connected(true);
+    transport_cdc_service();
+    CHECK(transport_cdc.ready());
+
+    size_t room = transport_cdc.room(TRANSPORT_LANE_BULK);
+    CHECK(room > sizeof(frame));
+    for (size_t i = 0; i < sizeof(frame); i++)
+        frame[i] = (uint8_t)(i + 1);
+    CHECK(transport_cdc.write(TRANSPORT_LANE_BULK, frame, sizeof(frame)));
+    CHECK(transport_cdc.room(TRANSPORT_LANE_BULK) == room - sizeof(frame));
+    CHECK(transport_cdc.pending(TRANSPORT_LANE_BULK) == sizeof(frame));
+    CHECK(fake_cdc_host_read(buf, sizeof(buf)) == 0);
+
+    transport_cdc_service();
+    CHECK(transport_cdc.room(TRANSPORT_LANE_BULK) == room);
+    CHECK(transport_cdc.pending(TRANSPORT_LANE_BULK) == sizeof(frame));  // in the USB FIFO
+    CHECK(fake_cdc_host_read(buf, sizeof(buf)) == sizeof(frame));
+    CHECK(memcmp(buf, frame, sizeof(frame)) == 0);
+    transport_cdc_service();
+    CHECK(transport_cdc.pending(TRANSPORT_LANE_BULK) == 0);
+
+    // All or nothing
+    CHECK(!transport_cdc.write(TRANSPORT_LANE_BULK, buf, room + 1));
+
+    // Host -> device
+    CHECK(transport_cdc.read(buf, sizeof(buf)) == 0);
+    CHECK(fake_cdc_host_write(frame, 10) == 10);
+    transport_cdc_service();
+    CHECK(transport_cdc.read(buf, sizeof(buf)) == 10);
+    CHECK(memcmp(buf, frame, 10) == 0);
+
+    // Closing the port discards what was still queued
+    CHECK(transport_cdc.write(TRANSPORT_LANE_BULK, frame, sizeof(frame)));
+    fake_cdc_set_connected(false);
+    transport_cdc_service();
+    CHECK(!transport_cdc.ready());
+    CHECK(transport_cdc.pending(TRANSPORT_LANE_BULK) == 0);
+    CHECK(fake_cdc_host_read(buf, sizeof(buf)) == 0);
+}
+
+// With the scheduler running: an encoder task fans frames out to a fake
+// link and the CDC transport while a USB task services TinyUSB. Every
+// byte arrives in order on both, and TinyUSB is only ever called from the
+// USB task.
+static volatile bool stream_done = false;
+static uint8_t host_rx[STREAM_FRAMES * 8];
+static size_t host_len = 0;
+
+static void usb_task(void *p) {
+    (void)p;
+    fake_tusb_set_owner();
+    while (!stream_done || transport_cdc.pending(TRANSPORT_LANE_BULK) > 0) {
+        ulTaskNotifyTake(pdTRUE, 1);
+        transport_cdc_service();
+        host_len += fake_cdc_host_read(&host_rx[host_len], sizeof(host_rx) - host_len);
+    }
+    vTaskEndScheduler();
+}
+
+static void encoder_task(void *p) {
+    (void)p;
+    link_a.ready = true;
+    link_a.capacity = sizeof(link_a.data);
+    link_a.len = 0;
+
+    for (int i = 0; i < STREAM_FRAMES;) {
+        uint8_t frame[8];
+        for (size_t k = 0; k < sizeof(frame); k++)
+            frame[k] = (uint8_t)(i * 8 + k);
+        if (transport_room(TRANSPORT_LANE_BULK) < sizeof(frame)) {
+            vTaskDelay(1);
+            continue;
+        }
+        CHECK(transport_send(TRANSPORT_LANE_BULK, frame, sizeof(frame), 0));
+        // The fake link is drained as soon as it fills
+        if (link_a.len + sizeof(frame) > link_a.capacity)
+            link_a.len = 0;
+        i++;
+    }
+    stream_done = true;
+    vTaskSuspend(NULL);
+}
+
+static void test_cdc_tasks(void) {
+    fake_cdc_set_connected(true);
+    transport_cdc_service();
+    uint32_t drops = transport_cdc.stats.drops;
+
+    xTaskCreate(usb_task, "USB", configMINIMAL_STACK_SIZE * 4, NULL, 2, &usb_task_handle);
+    xTaskCreate(encoder_task, "UART", configMINIMAL_STACK_SIZE * 4, NULL, 1, NULL);
+    vTaskStartScheduler();
+
+    CHECK(fake_tusb_foreign_calls() == 0);
+    CHECK(transport_cdc.stats.drops == drops);
+    CHECK(host_len == STREAM_FRAMES * 8);
+    for (size_t i = 0; i < host_len; i++) {
+        if (host_rx[i] != (uint8_t)i) {
+            CHECK(host_rx[i] == (uint8_t)i);
+            break;
+        }
+    }
+}
+
+int main(void) {
+    test_fan_out();
+    test_stall();
+    test_cdc_buffers();
+    test_cdc_tasks();
+    return check_result("test_transport");
+}
@@ -0,0 +1,160 @@
+#include <string.h>
+#include "check.h"
+#include "uart_tx.h"
+
+// Everything the receiver saw, and what the writers queued, in order
+static uint8_t wire[256 * 1024];
+static size_t wire_len;
+static uint8_t expected[256 * 1024];
+static size_t expected_len;
+
+// The line takes a few bytes at a time; the TX IRQ refills the FIFO
+static void drain(void) {
+    size_t n;
+    do {
+        n = fake_uart_shift(uart0, wire + wire_len, 3);
+        wire_len += n;
+    } while (n > 0);
+}
+
+static void reset(void) {
+    drain();
+    uart_tx_init(uart0);
+    wire_len = 0;
+    expected_len = 0;
+}
+
+// len - 1 non-zero bytes and the delimiter
+static size_t make_frame(uint8_t *buf, size_t len, uint8_t fill) {
+    for (size_t i = 0; i + 1 < len; i++)
+        buf[i] = fill ? fill : 1 + check_rand() % 255;
+    buf[len - 1] = 0x00;
+    return len;
+}
+
+static bool write_expect(uart_tx_lane_t lane, const uint8_t *data, size_t len) {
+    if (!uart_tx_write_lane(lane, data, len))
+        return false;
+    memcpy(expected + expected_len, data, len);
+    expected_len += len;
+    return true;
+}
+
+static size_t find(const uint8_t *data, size_t len) {
+    for (size_t i = 0; i + len <= wire_len; i++)
+        if (memcmp(wire + i, data, len) == 0)
+            return i;
+    return (size_t)-1;
+}
+
+// Enough traffic to wrap the 16-bit head/tail counters a few times
+static void test_roundtrip_wrap(void) {
+    uint8_t frame[40];
+
+    reset();
+    while (expected_len < sizeof(expected) - sizeof(frame)) {
+        size_t len = make_frame(frame, 2 + check_rand() % (sizeof(frame) - 1), 0);
+        if (uart_tx_free() < len)
+            drain();
+        CHECK(write_expect(UART_TX_LANE_BULK, frame, len));
+        if (check_rand() % 4 == 0)
+            drain();
+    }
+    drain();
+    CHECK(wire_len == expected_len);
+    CHECK(memcmp(wire, expected, expected_len) == 0);
+    CHECK(uart_tx_idle());
+}
+
+// A write that does not fit is rejected whole and counted
+static void test_all_or_nothing(void) {
+    uint8_t frame[UART_TX_RING_SIZE];
+    uart_tx_stats_t before, after;
+
+    reset();
+    uart_tx_get_stats(&before);
+    CHECK(write_expect(UART_TX_LANE_BULK, frame, make_frame(frame, 200, 0x11)));
+    // The first FIFO load already left the ring
+    CHECK(uart_tx_free() == UART_TX_RING_SIZE - 200 + UART_FIFO_DEPTH);
+
+    size_t room = uart_tx_free();
+    CHECK(!uart_tx_write(frame, room + 1));
+    CHECK(uart_tx_free() == room);
+    CHECK(write_expect(UART_TX_LANE_BULK, frame, make_frame(frame, room, 0x22)));
+    CHECK(uart_tx_free() == 0);
+
+    uart_tx_get_stats(&after);
+    CHECK(after.overflows == before.overflows + 1);
+    CHECK(after.peak_fill >= UART_TX_RING_SIZE);
+
+    drain();
+    CHECK(wire_len == expected_len);
+    CHECK(memcmp(wire, expected, expected_len) == 0);
+}
+
+// Queued bulk frames wait while an edge frame goes first; the bulk frame
+// already on the wire is never cut
+static void test_edge_priority(void) {
+    uint8_t bulk[3][60], edge[6];
+
+    reset();
+    for (int i = 0; i < 3; i++)
+        CHECK(uart_tx_write(bulk[i], make_frame(bulk[i], sizeof(bulk[i]), 0x30 + i)));
+    CHECK(uart_tx_write_lane(UART_TX_LANE_EDGE, edge, make_frame(edge, sizeof(edge), 0x7E)));
+    drain();
+
+    CHECK(wire_len == 3 * sizeof(bulk[0]) + sizeof(edge));
+    CHECK(find(bulk[0], sizeof(bulk[0])) == 0);
+    CHECK(find(edge, sizeof(edge)) == sizeof(bulk[0]));
+    CHECK(find(bulk[1], sizeof(bulk[1])) == sizeof(bulk[0]) + sizeof(edge));
+    CHECK(find(bulk[2], sizeof(bulk[2])) == 2 * sizeof(bulk[0]) + sizeof(edge));
+}
+
+// Edge frames written while the bulk lane is busy all come out before the
+// remaining bulk frames, each one whole
+static void test_edge_burst(void) {
+    uint8_t bulk[4][30], edge[3][5];
+
+    reset();
+    for (int i = 0; i < 4; i++)
+        CHECK(uart_tx_write(bulk[i], make_frame(bulk[i], sizeof(bulk[i]), 0x40 + i)));
+    for (int i = 0; i < 3; i++) {
+        fake_uart_shift(uart0, wire + wire_len, 4);
+        wire_len += 4;
+        CHECK(uart_tx_write_lane(UART_TX_LANE_EDGE, edge[i], make_frame(edge[i], sizeof(edge[i]), 0x70 + i)));
+    }
+    drain();
+
+    size_t last_edge = 0;
+    for (int i = 0; i < 3; i++) {
+        size_t at = find(edge[i], sizeof(edge[i]));
+        CHECK(at != (size_t)-1 && at >= last_edge);
+        last_edge = at;
+    }
+    CHECK(last_edge < find(bulk[2], sizeof(bulk[2])));
+}
+
+// AT text has no delimiter: the lane is released once its ring runs dry
+static void test_at_text(void) {
+    static const uint8_t at[] = "AT+VERSION";
+    uint8_t edge[4];
+
+    reset();
+    CHECK(write_expect(UART_TX_LANE_BULK, at, sizeof(at) - 1));
+    drain();
+    CHECK(write_expect(UART_TX_LANE_EDGE, edge, make_frame(edge, sizeof(edge), 0x55)));
+    CHECK(write_expect(UART_TX_LANE_BULK, at, sizeof(at) - 1));
+    drain();
+    CHECK(wire_len == expected_len);
+    CHECK(memcmp(wire, expected, expected_len) == 0);
+    CHECK(uart_tx_idle());
+}
+
+int main(void) {
+    test_roundtrip_wrap();
+    test_all_or_nothing();
+    test_edge_priority();
+    test_edge_burst();
+    test_at_text();
+    return check_result("test_uart_tx");
+}
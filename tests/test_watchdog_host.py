@@ -0,0 +1,130 @@
+"""Heartbeat e watchdog do host (python/main.py) num link simulado."""
+
+import contextlib
+import io
+import unittest
+
+import protocol
+from link_simulado import FimSimulacao, LinkSimulado, importar_main
+
+main, teclado = importar_main()
+
+TECLA_W = 0x01  # map_codigo_para_tecla(0x01) == ['w']
+
+
+def rodar(link):
+    with contextlib.redirect_stdout(io.StringIO()):
+        try:
+            main.controle(link, timeout_link=1.0)
+        except FimSimulacao:
+            pass
+
+
+def instantes(acao, tecla='w'):
+    return [t for t, a, k in teclado.historico if a == acao and k == tecla]
+
+
+class TestWatchdog(unittest.TestCase):
+    def setUp(self):
+        teclado.pressionadas.clear()
+        teclado.historico.clear()
+
+    def test_heartbeat_e_pequeno(self):
+        quadro = protocol.encode_frame(protocol.HEARTBEAT.pack(0, protocol.CODE_HEARTBEAT))
+        self.assertEqual(len(quadro), 5)
+
+    def test_heartbeats_mantem_o_link(self):
+        """Parado mas vivo: a tecla segurada não é solta."""
+        link = LinkSimulado(main, teclado, fim=6.0)
+        link.borda(0.1, TECLA_W)
+        link.heartbeats(0.35, 6.0)
+        rodar(link)
+        self.assertEqual(len(instantes('press')), 1)
+        self.assertAlmostEqual(instantes('press')[0], 0.1, delta=link.passo)
+        self.assertEqual(instantes('release'), [])
+        self.assertIn('w', teclado.pressionadas)
+
+    def test_queda_solta_teclas_e_volta_com_estado(self):
+        """Link cai com 'w' apertada: solta depois do timeout e reaperta no resync."""
+        link = LinkSimulado(main, teclado, fim=5.0)
+        link.borda(0.1, TECLA_W)
+        link.heartbeats(0.35, 1.0)
+        # Silêncio de 1,0 s a 3,0 s; depois os heartbeats voltam
+        link.heartbeats(3.0, 5.0)
+
+        def firmware(t, payload):
+            # O botão continua apertado: o pedido de resync traz o estado
+            if payload[0] == protocol.CMD_RESYNC and t > 2.5:
+                link.estado(t + 0.02, {TECLA_W})
+        link.ao_receber = firmware
+        rodar(link)
+
+        soltas = instantes('release')
+        self.assertEqual(len(soltas), 1)
+        # Último quadro em ~0,85 s, timeout de 1 s
+        self.assertGreater(soltas[0], 1.8)
+        self.assertLess(soltas[0], 1.9)
+
+        resyncs = [t for t in link.comandos_enviados(protocol.CMD_RESYNC) if t > 2.5]
+        # Os de antes (~1,85 s e ~2,85 s) pedem o HELLO com o link morto
+        hellos = [t for t in link.comandos_enviados(protocol.CMD_HELLO) if t > 2.95]
+        self.assertEqual(len(resyncs), 1)
+        self.assertEqual(len(hellos), 1)
+        self.assertLess(resyncs[0], 3.05)
+
+        apertos = instantes('press')
+        self.assertEqual(len(apertos), 2)
+        self.assertLess(apertos[1], 3.1)
+        self.assertIn('w', teclado.pressionadas)
+
+    def test_reinicio_com_fec(self):
+        """O dispositivo reinicia com FEC negociado e volta no formato
+        original sem anunciar nada (o HELLO de boot se perdeu). O host
+        tem que pedir o HELLO de novo, senão recusa todo quadro."""
+        link = LinkSimulado(main, teclado, fim=9.0)
+        link.heartbeats(0.1, 3.0)
+        link.heartbeats(7.0, 9.0)
+        link.borda(8.0, TECLA_W)
+
+        def firmware(t, payload):
+            if 3.0 <= t < 7.0:
+                return  # reiniciando, HC-06 ainda sem host
+            if payload[0] == protocol.CMD_HELLO:
+                link.hello(t + 0.01, protocol.FMT_FEC)
+            elif payload[0] == protocol.CMD_SET_FORMAT:
+                link.fec = bool(payload[1] & protocol.FMT_FEC)
+
+        def reiniciar(t):
+            if 3.0 <= t < 3.0 + link.passo:
+                link.fec = False
+        link.ao_receber = firmware
+        link.a_cada_passo = reiniciar
+
+        usar_fec = main.USAR_FEC
+        main.USAR_FEC = True
+        try:
+            rodar(link)
+        finally:
+            main.USAR_FEC = usar_fec
+
+        self.assertTrue(link.fec)
+        formatos = link.comandos_enviados(protocol.CMD_SET_FORMAT)
+        self.assertTrue(any(t < 1.0 for t in formatos))
+        self.assertTrue(any(7.0 <= t < 8.0 for t in formatos))
+        apertos = instantes('press')
+        self.assertEqual(len(apertos), 1)
+        self.assertLess(apertos[0], 8.05)
+
+    def test_keepalive_continua_com_link_morto(self):
+        """Sem keepalive o HC-06 pausa o envio e o link nunca voltaria."""
+        link = LinkSimulado(main, teclado, fim=4.0)
+        link.heartbeats(0.0, 0.5)
+        rodar(link)
+        keepalives = link.comandos_enviados(protocol.CMD_KEEPALIVE)
+        self.assertTrue(any(t > 3.0 for t in keepalives))
+        intervalos = [b - a for a, b in zip(keepalives, keepalives[1:])]
+        self.assertLessEqual(max(intervalos), main.INTERVALO_KEEPALIVE + 0.01)
+
+
+if __name__ == '__main__':
+    unittest.main()